@@ -4,7 +4,6 @@
 #include <mpfr.h>
 #include "mpfr_base32.h"
 
-#define MAX_LINE_LENGTH 4096
 #define DEFAULT_PRECISION 256
 
 /**
@@ -111,44 +110,51 @@ void convert_32_to_10(const char *base32_str, mpfr_prec_t precision) {
     int sign_offset = (base10_str[0] == '-') ? 1 : 0;
     size_t mantissa_len = len - sign_offset;
     
-    // Print sign if present
-    if (sign_offset) {
-        printf("-");
+    // Sized for the digits plus "0.", padding zeros and the terminator
+    size_t output_size = mantissa_len + 3;
+    if (exp > 0 && (size_t)exp > mantissa_len) {
+        output_size += exp - mantissa_len;
+    } else if (exp < 0) {
+        output_size += -exp;
+    }
+    char *output = malloc(output_size);
+    if (output == NULL) {
+        printf("ERROR: Conversion failed\n");
+        mpfr_free_str(base10_str);
+        mpfr_clear(value);
+        return;
     }
-    
-    // Build output string in a buffer for trailing zero removal
-    char output[4096];
     char *out_ptr = output;
     
     if (exp > 0) {
         if ((size_t)exp >= mantissa_len) {
             // Integer with trailing zeros
-            out_ptr += sprintf(out_ptr, "%s", base10_str + sign_offset);
-            for (long i = mantissa_len; i < exp; i++) {
-                *out_ptr++ = '0';
-            }
+            memcpy(out_ptr, base10_str + sign_offset, mantissa_len);
+            out_ptr += mantissa_len;
+            memset(out_ptr, '0', exp - mantissa_len);
+            out_ptr += exp - mantissa_len;
             *out_ptr = '\0';
         } else {
             // Insert decimal point
-            for (long i = 0; i < exp; i++) {
-                *out_ptr++ = base10_str[sign_offset + i];
-            }
+            memcpy(out_ptr, base10_str + sign_offset, exp);
+            out_ptr += exp;
             *out_ptr++ = '.';
             strcpy(out_ptr, base10_str + sign_offset + exp);
         }
     } else {
         // Leading zeros
-        out_ptr += sprintf(out_ptr, "0.");
-        for (long i = 0; i < -exp; i++) {
-            *out_ptr++ = '0';
-        }
+        *out_ptr++ = '0';
+        *out_ptr++ = '.';
+        memset(out_ptr, '0', -exp);
+        out_ptr += -exp;
         strcpy(out_ptr, base10_str + sign_offset);
     }
     
     // Remove trailing zeros before printing
     remove_trailing_zeros(output);
-    printf("%s\n", output);
+    printf("%s%s\n", sign_offset ? "-" : "", output);
     
+    free(output);
     mpfr_free_str(base10_str);
     mpfr_clear(value);
 }
@@ -157,10 +163,13 @@ void convert_32_to_10(const char *base32_str, mpfr_prec_t precision) {
  * Print usage information
  */
 void print_usage(const char *program_name) {
-    printf("Usage: %s <command> [options]\n\n", program_name);
+    printf("Usage: %s <command> [options]\n", program_name);
+    printf("       %s --stream\n\n", program_name);
     printf("Commands:\n");
     printf("  10TO32 <precision> <base10_number>  Convert base-10 to base-32\n");
-    printf("  32TO10 <precision> <base32_number>  Convert base-32 to base-10\n\n");
+    printf("  32TO10 <precision> <base32_number>  Convert base-32 to base-10\n");
+    printf("  --stream                            Read \"<command> <precision> <number>\" lines\n");
+    printf("                                      from stdin until EOF, one result line each\n\n");
     printf("Options:\n");
     printf("  <precision>     Precision in bits (e.g., 64, 128, 256)\n");
     printf("  <base10_number> Number in base-10 format (e.g., -0.5, 123.456, 1e-10)\n");
@@ -172,10 +181,81 @@ void print_usage(const char *program_name) {
     printf("  %s 32TO10 128 0.8\n", program_name);
 }
 
+/**
+ * Check a precision argument
+ *
+ * @return 0 if valid, non-zero otherwise
+ */
+static int check_precision(long precision) {
+    return (precision <= 0 || precision > MPFR_PREC_MAX) ? -1 : 0;
+}
+
+/**
+ * Run one conversion command
+ *
+ * @return 0 if the command is known, non-zero otherwise
+ */
+static int run_conversion(const char *command, long precision, const char *number) {
+    if (strcmp(command, "10TO32") == 0) {
+        convert_10_to_32(number, precision);
+    } else if (strcmp(command, "32TO10") == 0) {
+        convert_32_to_10(number, precision);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Convert "<command> <precision> <number>" lines from stdin until EOF,
+ * printing exactly one result or ERROR line per input line. Lines are read
+ * into a growing buffer, so numbers of any length are accepted.
+ */
+static void run_stream(void) {
+    char *line = NULL;
+    size_t line_size = 0;
+    
+    while (getline(&line, &line_size, stdin) != -1) {
+        char *fields[3];
+        int field_count = 0;
+        char *rest = line;
+        
+        // Split into whitespace-separated fields in place
+        while (field_count < 3) {
+            rest += strspn(rest, " \t\r\n");
+            if (*rest == '\0') {
+                break;
+            }
+            fields[field_count++] = rest;
+            rest += strcspn(rest, " \t\r\n");
+            if (*rest != '\0') {
+                *rest++ = '\0';
+            }
+        }
+        rest += strspn(rest, " \t\r\n");
+        
+        if (field_count < 3 || *rest != '\0') {
+            printf("ERROR: Expected <command> <precision> <number>\n");
+        } else if (check_precision(atol(fields[1])) != 0) {
+            printf("ERROR: Invalid precision\n");
+        } else if (run_conversion(fields[0], atol(fields[1]), fields[2]) != 0) {
+            printf("ERROR: Unknown command '%s'\n", fields[0]);
+        }
+        fflush(stdout);
+    }
+    
+    free(line);
+}
+
 /**
  * Main function
  */
 int main(int argc, char *argv[]) {
+    if (argc == 2 && strcmp(argv[1], "--stream") == 0) {
+        run_stream();
+        return 0;
+    }
+    
     if (argc < 4) {
         print_usage(argv[0]);
         return 1;
@@ -185,16 +265,12 @@ int main(int argc, char *argv[]) {
     long precision = atol(argv[2]);
     const char *number = argv[3];
     
-    if (precision <= 0) {
+    if (check_precision(precision) != 0) {
         printf("ERROR: Invalid precision\n");
         return 1;
     }
     
-    if (strcmp(command, "10TO32") == 0) {
-        convert_10_to_32(number, precision);
-    } else if (strcmp(command, "32TO10") == 0) {
-        convert_32_to_10(number, precision);
-    } else {
+    if (run_conversion(command, precision, number) != 0) {
         printf("ERROR: Unknown command '%s'\n", command);
         print_usage(argv[0]);
         return 1;
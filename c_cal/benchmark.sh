@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# Throughput benchmark for the CAL iteration loop
+# Usage: ./benchmark.sh [mandelbrot_binary ...]
+#
+# Runs one slowly escaping point near the neck of the main cardioid
+# (c = -0.75 + 0.000001i, which needs ~3 million iterations to escape)
+# at several precisions and prints iterations per second for every binary
+# given. Pass an older build as a second argument to compare before/after.
+
+if [ $# -eq 0 ]; then
+    set -- ./mandelbrot
+fi
+
+for binary in "$@"; do
+    if [ ! -x "$binary" ]; then
+        echo "Error: $binary not found!"
+        echo "Please run 'make' first to build the program."
+        exit 1
+    fi
+done
+
+CA="-0.o"
+CB="0.00011hnnk2qur39mo"
+
+# Iteration budget per precision, scaled so each run takes about a second
+iterations_for() {
+    case $1 in
+        64)   echo 2000000 ;;
+        128)  echo 1000000 ;;
+        256)  echo 500000 ;;
+        512)  echo 250000 ;;
+        1024) echo 100000 ;;
+        2048) echo 40000 ;;
+        *)    echo 15000 ;;
+    esac
+}
+
+echo "========================================"
+echo "Mandelbrot Calculator - Benchmark"
+echo "========================================"
+echo ""
+
+printf "%-10s %-12s" "precision" "iterations"
+for binary in "$@"; do
+    printf " %20s" "$binary"
+done
+echo ""
+
+for precision in 64 128 256 512 1024 2048 4096; do
+    iterations=$(iterations_for $precision)
+    printf "%-10s %-12s" "$precision" "$iterations"
+    for binary in "$@"; do
+        start=$(date +%s.%N)
+        echo -e "CAL $precision 0 0 $CA $CB $iterations 2\nEXIT" | "$binary" > /dev/null
+        end=$(date +%s.%N)
+        rate=$(echo "$start $end $iterations" | awk '{ printf "%.0f", $3 / ($2 - $1) }')
+        printf " %14s iter/s" "$rate"
+    done
+    echo ""
+done
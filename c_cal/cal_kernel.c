@@ -0,0 +1,670 @@
+#include "cal_kernel.h"
+#include "mpfr_base32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+
+/**
+ * Fused Mandelbrot iteration kernel.
+ *
+ * Iterates z = z^2 + c in place on (z_real, z_imag) for at most
+ * max_iterations steps, stopping early when |z|^2 > escape_radius_squared.
+ * All temporaries are initialized once per call, and the squares computed
+ * for the escape test are reused by the next step's update, so each
+ * iteration costs two squarings, one multiplication and a shift.
+ *
+ * If period is not NULL the orbit is also checked for cycles with Brent's
+ * algorithm: z is compared with a saved point that is refreshed whenever
+ * the distance since the last save reaches a power of two.
+ *
+ * If dz_real is not NULL the derivative dz/dc is updated from the z of each
+ * step before z itself, at the precision of dz_real.
+ *
+ * @param escaped Set to 'Y' if the orbit escaped, 'P' if it is periodic,
+ *                'N' otherwise
+ * @return Number of iterations performed
+ */
+long iterate_mpfr(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb,
+                  mpfr_t escape_radius_squared, long max_iterations,
+                  int verbose, char *escaped, long *period,
+                  mpfr_ptr dz_real, mpfr_ptr dz_imag) {
+    mpfr_t z_real_sq, z_imag_sq, z_magnitude_squared;
+    mpfr_t saved_real, saved_imag, distance;
+    mpfr_t dz_next;
+    mpfr_prec_t prec = mpfr_get_prec(z_real);
+    mpfr_exp_t tolerance_exp = PERIOD_TOLERANCE_BITS - prec;
+    long iterations = 0;
+    long power = 1, lambda = 0;
+    base32_buffer_t step_za_text = { NULL, 0 };
+    base32_buffer_t step_zb_text = { NULL, 0 };
+    
+    mpfr_init2(z_real_sq, prec);
+    mpfr_init2(z_imag_sq, prec);
+    mpfr_init2(z_magnitude_squared, prec);
+    mpfr_init2(saved_real, prec);
+    mpfr_init2(saved_imag, prec);
+    mpfr_init2(distance, prec);
+    if (dz_real != NULL) {
+        mpfr_init2(dz_next, mpfr_get_prec(dz_real));
+    }
+    
+    // Squares of z0, consumed by the first update
+    mpfr_sqr(z_real_sq, z_real, MPFR_RNDN);
+    mpfr_sqr(z_imag_sq, z_imag, MPFR_RNDN);
+    
+    mpfr_set(saved_real, z_real, MPFR_RNDN);
+    mpfr_set(saved_imag, z_imag, MPFR_RNDN);
+    
+    *escaped = 'N';
+    if (period != NULL) {
+        *period = 0;
+    }
+    
+    for (long i = 0; i < max_iterations; i++) {
+        // dz = 2 z dz + 1, from the z of this step
+        if (dz_real != NULL) {
+            mpfr_fmms(dz_next, z_real, dz_real, z_imag, dz_imag, MPFR_RNDN);
+            mpfr_fmma(dz_imag, z_real, dz_imag, z_imag, dz_real, MPFR_RNDN);
+            mpfr_mul_2ui(dz_imag, dz_imag, 1, MPFR_RNDN);
+            mpfr_mul_2ui(dz_next, dz_next, 1, MPFR_RNDN);
+            mpfr_add_ui(dz_real, dz_next, 1, MPFR_RNDN);
+        }
+        
+        // z_imag = 2 * z_real * z_imag + cb (the doubling is an exact shift)
+        mpfr_mul(z_imag, z_real, z_imag, MPFR_RNDN);
+        mpfr_mul_2ui(z_imag, z_imag, 1, MPFR_RNDN);
+        mpfr_add(z_imag, z_imag, cb, MPFR_RNDN);
+        
+        // z_real = z_real^2 - z_imag^2 + ca
+        mpfr_sub(z_real, z_real_sq, z_imag_sq, MPFR_RNDN);
+        mpfr_add(z_real, z_real, ca, MPFR_RNDN);
+        
+        iterations = i + 1;
+        
+        // Output verbose step information if requested
+        if (verbose) {
+            const char *step_za_str = mpfr_to_base32_reuse(z_real, &step_za_text);
+            const char *step_zb_str = mpfr_to_base32_reuse(z_imag, &step_zb_text);
+            if (step_za_str != NULL && step_zb_str != NULL) {
+                printf("CAL_STEP %s %s %ld\n", step_za_str, step_zb_str, iterations);
+                fflush(stdout);
+            }
+        }
+        
+        // Check if |z|^2 > escape_radius^2; the squares are kept for the next step
+        mpfr_sqr(z_real_sq, z_real, MPFR_RNDN);
+        mpfr_sqr(z_imag_sq, z_imag, MPFR_RNDN);
+        mpfr_add(z_magnitude_squared, z_real_sq, z_imag_sq, MPFR_RNDN);
+        
+        if (mpfr_cmp(z_magnitude_squared, escape_radius_squared) > 0) {
+            *escaped = 'Y';
+            break;
+        }
+        
+        if (period != NULL) {
+            lambda++;
+            mpfr_sub(distance, z_real, saved_real, MPFR_RNDN);
+            if (mpfr_zero_p(distance) || mpfr_get_exp(distance) <= tolerance_exp) {
+                mpfr_sub(distance, z_imag, saved_imag, MPFR_RNDN);
+                if (mpfr_zero_p(distance) || mpfr_get_exp(distance) <= tolerance_exp) {
+                    *escaped = 'P';
+                    *period = lambda;
+                    break;
+                }
+            }
+            if (lambda == power) {
+                mpfr_set(saved_real, z_real, MPFR_RNDN);
+                mpfr_set(saved_imag, z_imag, MPFR_RNDN);
+                power *= 2;
+                lambda = 0;
+            }
+        }
+    }
+    
+    free(step_za_text.data);
+    free(step_zb_text.data);
+    mpfr_clear(z_real_sq);
+    mpfr_clear(z_imag_sq);
+    mpfr_clear(z_magnitude_squared);
+    mpfr_clear(saved_real);
+    mpfr_clear(saved_imag);
+    mpfr_clear(distance);
+    if (dz_real != NULL) {
+        mpfr_clear(dz_next);
+    }
+    
+    return iterations;
+}
+
+/*
+ * Hardware kernels.
+ *
+ * Every IEEE operation is correctly rounded to nearest, exactly like the
+ * MPFR calls in iterate_mpfr(), so as long as no intermediate value leaves
+ * the normal exponent range the two paths agree bit for bit. Overflow is
+ * ruled out up front by hw_inputs_fit(); underflow can only come from the
+ * multiplications, so each kernel checks the squares of the new z and, if
+ * one of them is inexact, returns the previous z and lets the caller finish
+ * in MPFR. An early return is recognizable as iterations < max_iterations
+ * with *escaped == 'N'. The periodicity state is not handed over, so after
+ * an early return a cycle may be found at a different iteration than by
+ * iterate_mpfr() alone.
+ *
+ * If dz_real is not NULL the derivative dz/dc is carried in the same type.
+ * It grows much faster than z, so a step whose derivative would leave
+ * [-derivative_limit, derivative_limit] also returns early to MPFR.
+ *
+ * The periodicity check accepts a distance strictly below period_tolerance
+ * in both coordinates, the bound of the exponent test in iterate_mpfr().
+ */
+#define DEFINE_HW_KERNEL(name, T, MIN_NORMAL)                                  \
+static long name(T *z_real, T *z_imag, T ca, T cb, T escape_radius_squared,    \
+                 long max_iterations, T period_tolerance,                      \
+                 char *escaped, long *period,                                  \
+                 T *dz_real, T *dz_imag, T derivative_limit) {                 \
+    const T square_limit = (MIN_NORMAL) * 4;                                   \
+    T x = *z_real, y = *z_imag;                                                \
+    T x2 = x * x, y2 = y * y;                                                  \
+    T saved_x = x, saved_y = y;                                                \
+    T dx = 0, dy = 0;                                                          \
+    long iterations = 0;                                                       \
+    long power = 1, lambda = 0;                                                \
+                                                                               \
+    *escaped = 'N';                                                            \
+    if ((x2 < square_limit && x != 0) || (y2 < square_limit && y != 0)) {      \
+        return 0;                                                              \
+    }                                                                          \
+    if (dz_real != NULL) {                                                     \
+        dx = *dz_real;                                                         \
+        dy = *dz_imag;                                                         \
+    }                                                                          \
+                                                                               \
+    for (long i = 0; i < max_iterations; i++) {                                \
+        T xy = x * y;                                                          \
+        T new_y = (xy * 2) + cb;                                               \
+        T new_x = (x2 - y2) + ca;                                              \
+        T new_x2 = new_x * new_x;                                              \
+        T new_y2 = new_y * new_y;                                              \
+                                                                               \
+        if ((new_x2 < square_limit || new_y2 < square_limit) &&                \
+            ((new_x2 < square_limit && new_x != 0) ||                          \
+             (new_y2 < square_limit && new_y != 0))) {                         \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        if (dz_real != NULL) {                                                 \
+            T new_dx = (x * dx - y * dy) * 2 + 1;                              \
+            T new_dy = (x * dy + y * dx) * 2;                                  \
+            if (new_dx > derivative_limit || new_dx < -derivative_limit ||     \
+                new_dy > derivative_limit || new_dy < -derivative_limit) {     \
+                break;                                                         \
+            }                                                                  \
+            dx = new_dx;                                                       \
+            dy = new_dy;                                                       \
+        }                                                                      \
+                                                                               \
+        x = new_x;                                                             \
+        y = new_y;                                                             \
+        x2 = new_x2;                                                           \
+        y2 = new_y2;                                                           \
+        iterations = i + 1;                                                    \
+                                                                               \
+        if (x2 + y2 > escape_radius_squared) {                                 \
+            *escaped = 'Y';                                                    \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        if (period != NULL) {                                                  \
+            lambda++;                                                          \
+            T diff_x = x - saved_x, diff_y = y - saved_y;                      \
+            if (diff_x < period_tolerance && diff_x > -period_tolerance &&     \
+                diff_y < period_tolerance && diff_y > -period_tolerance) {     \
+                *escaped = 'P';                                                \
+                *period = lambda;                                              \
+                break;                                                         \
+            }                                                                  \
+            if (lambda == power) {                                             \
+                saved_x = x;                                                   \
+                saved_y = y;                                                   \
+                power *= 2;                                                    \
+                lambda = 0;                                                    \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    *z_real = x;                                                               \
+    *z_imag = y;                                                               \
+    if (dz_real != NULL) {                                                     \
+        *dz_real = dx;                                                         \
+        *dz_imag = dy;                                                         \
+    }                                                                          \
+    return iterations;                                                         \
+}
+
+DEFINE_HW_KERNEL(iterate_double, double, DBL_MIN)
+DEFINE_HW_KERNEL(iterate_long_double, long double, LDBL_MIN)
+
+#ifdef __SIZEOF_FLOAT128__
+#define FLOAT128_MANT_DIG 113
+#define FLOAT128_MAX_EXP 16384
+#define FLOAT128_MIN_EXP (-16381)
+#define FLOAT128_MIN 3.36210314311209350626267781732175260e-4932Q
+
+DEFINE_HW_KERNEL(iterate_float128, __float128, FLOAT128_MIN)
+
+/*
+ * MPFR's own __float128 conversions are optional at MPFR build time, so
+ * values are split into a long double head and tail instead. With at most
+ * 113 significant bits the tail fits in the remaining long double mantissa,
+ * so both directions are exact apart from the final rounding to the
+ * precision of the destination. head and tail are FLOAT128_MANT_DIG-bit
+ * scratch variables.
+ */
+static __float128 mpfr_get_float128_exact(mpfr_t value, mpfr_t head, mpfr_t tail) {
+    long double head_ld = mpfr_get_ld(value, MPFR_RNDN);
+    mpfr_set_ld(head, head_ld, MPFR_RNDN);
+    mpfr_sub(tail, value, head, MPFR_RNDN);
+    return (__float128)head_ld + (__float128)mpfr_get_ld(tail, MPFR_RNDN);
+}
+
+static void mpfr_set_float128_exact(mpfr_t value, __float128 x, mpfr_t head, mpfr_t tail) {
+    long double head_ld = (long double)x;
+    mpfr_set_ld(head, head_ld, MPFR_RNDN);
+    mpfr_set_ld(tail, (long double)(x - (__float128)head_ld), MPFR_RNDN);
+    mpfr_add(value, head, tail, MPFR_RNDN);
+}
+#endif
+
+/**
+ * Check that every input of a hardware kernel converts exactly and that no
+ * intermediate value can overflow. Orbits are bounded by the escape radius,
+ * so limiting z0 and c to 1/8 and R^2 to 1/4 of the exponent range keeps
+ * every square well below the maximum. A derivative, if any, must stay
+ * below derivative_limit(), which the kernel keeps it under.
+ */
+static int hw_inputs_fit(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb,
+                         mpfr_t escape_radius_squared, mpfr_ptr dz_real, mpfr_ptr dz_imag,
+                         long max_exp, long min_exp) {
+    mpfr_ptr values[] = { z_real, z_imag, ca, cb, escape_radius_squared, dz_real, dz_imag };
+    long limits[] = { max_exp / 8, max_exp / 8, max_exp / 8, max_exp / 8, max_exp / 4,
+                      max_exp / 2, max_exp / 2 };
+    size_t count = (dz_real != NULL) ? 7 : 5;
+    
+    for (size_t i = 0; i < count; i++) {
+        if (mpfr_zero_p(values[i])) {
+            continue;
+        }
+        if (!mpfr_regular_p(values[i])) {
+            return 0;
+        }
+        mpfr_exp_t exp = mpfr_get_exp(values[i]);
+        if (exp > limits[i] || exp < min_exp / 2) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Largest derivative a hardware kernel carries, 2^(max_exp / 2): multiplied
+ * by a z below the escape radius it cannot overflow
+ */
+#define derivative_limit(T, max_exp) ((T)ldexpl(1.0L, (max_exp) / 2))
+
+/**
+ * Iterate with the hardware type whose mantissa is exactly the precision,
+ * finishing in MPFR. A wider type would round every step to more bits than
+ * MPFR does, so other precisions always use MPFR.
+ */
+long iterate_dispatch(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb,
+                      mpfr_t escape_radius_squared, long max_iterations,
+                      char *escaped, long *period,
+                      mpfr_ptr dz_real, mpfr_ptr dz_imag) {
+    mpfr_prec_t prec = mpfr_get_prec(z_real);
+    long iterations = 0;
+    
+    *escaped = 'N';
+    if (period != NULL) {
+        *period = 0;
+    }
+    
+    if (prec == DBL_MANT_DIG &&
+        hw_inputs_fit(z_real, z_imag, ca, cb, escape_radius_squared, dz_real, dz_imag,
+                      DBL_MAX_EXP, DBL_MIN_EXP)) {
+        double x = mpfr_get_d(z_real, MPFR_RNDN);
+        double y = mpfr_get_d(z_imag, MPFR_RNDN);
+        double dx = 0, dy = 0;
+        if (dz_real != NULL) {
+            dx = mpfr_get_d(dz_real, MPFR_RNDN);
+            dy = mpfr_get_d(dz_imag, MPFR_RNDN);
+        }
+        iterations = iterate_double(&x, &y,
+                                    mpfr_get_d(ca, MPFR_RNDN),
+                                    mpfr_get_d(cb, MPFR_RNDN),
+                                    mpfr_get_d(escape_radius_squared, MPFR_RNDN),
+                                    max_iterations,
+                                    ldexp(1.0, PERIOD_TOLERANCE_BITS - (int)prec),
+                                    escaped, period,
+                                    dz_real != NULL ? &dx : NULL, &dy,
+                                    derivative_limit(double, DBL_MAX_EXP));
+        mpfr_set_d(z_real, x, MPFR_RNDN);
+        mpfr_set_d(z_imag, y, MPFR_RNDN);
+        if (dz_real != NULL) {
+            mpfr_set_d(dz_real, dx, MPFR_RNDN);
+            mpfr_set_d(dz_imag, dy, MPFR_RNDN);
+        }
+    } else if (prec == LDBL_MANT_DIG &&
+               hw_inputs_fit(z_real, z_imag, ca, cb, escape_radius_squared, dz_real, dz_imag,
+                             LDBL_MAX_EXP, LDBL_MIN_EXP)) {
+        long double x = mpfr_get_ld(z_real, MPFR_RNDN);
+        long double y = mpfr_get_ld(z_imag, MPFR_RNDN);
+        long double dx = 0, dy = 0;
+        if (dz_real != NULL) {
+            dx = mpfr_get_ld(dz_real, MPFR_RNDN);
+            dy = mpfr_get_ld(dz_imag, MPFR_RNDN);
+        }
+        iterations = iterate_long_double(&x, &y,
+                                         mpfr_get_ld(ca, MPFR_RNDN),
+                                         mpfr_get_ld(cb, MPFR_RNDN),
+                                         mpfr_get_ld(escape_radius_squared, MPFR_RNDN),
+                                         max_iterations,
+                                         ldexpl(1.0L, PERIOD_TOLERANCE_BITS - (int)prec),
+                                         escaped, period,
+                                         dz_real != NULL ? &dx : NULL, &dy,
+                                         derivative_limit(long double, LDBL_MAX_EXP));
+        mpfr_set_ld(z_real, x, MPFR_RNDN);
+        mpfr_set_ld(z_imag, y, MPFR_RNDN);
+        if (dz_real != NULL) {
+            mpfr_set_ld(dz_real, dx, MPFR_RNDN);
+            mpfr_set_ld(dz_imag, dy, MPFR_RNDN);
+        }
+    }
+#ifdef __SIZEOF_FLOAT128__
+    else if (prec == FLOAT128_MANT_DIG &&
+             hw_inputs_fit(z_real, z_imag, ca, cb, escape_radius_squared, dz_real, dz_imag,
+                           FLOAT128_MAX_EXP, FLOAT128_MIN_EXP)) {
+        mpfr_t head, tail;
+        mpfr_init2(head, FLOAT128_MANT_DIG);
+        mpfr_init2(tail, FLOAT128_MANT_DIG);
+        
+        __float128 x = mpfr_get_float128_exact(z_real, head, tail);
+        __float128 y = mpfr_get_float128_exact(z_imag, head, tail);
+        __float128 ca_q = mpfr_get_float128_exact(ca, head, tail);
+        __float128 cb_q = mpfr_get_float128_exact(cb, head, tail);
+        __float128 r2_q = mpfr_get_float128_exact(escape_radius_squared, head, tail);
+        __float128 tolerance_q = ldexpl(1.0L, PERIOD_TOLERANCE_BITS - (int)prec);
+        __float128 dx = 0, dy = 0;
+        if (dz_real != NULL) {
+            dx = mpfr_get_float128_exact(dz_real, head, tail);
+            dy = mpfr_get_float128_exact(dz_imag, head, tail);
+        }
+        iterations = iterate_float128(&x, &y, ca_q, cb_q, r2_q, max_iterations,
+                                      tolerance_q, escaped, period,
+                                      dz_real != NULL ? &dx : NULL, &dy,
+                                      derivative_limit(__float128, FLOAT128_MAX_EXP));
+        mpfr_set_float128_exact(z_real, x, head, tail);
+        mpfr_set_float128_exact(z_imag, y, head, tail);
+        if (dz_real != NULL) {
+            mpfr_set_float128_exact(dz_real, dx, head, tail);
+            mpfr_set_float128_exact(dz_imag, dy, head, tail);
+        }
+        
+        mpfr_clear(head);
+        mpfr_clear(tail);
+    }
+#endif
+    
+    // Finish in MPFR if no hardware kernel applied or one stopped early
+    if (*escaped == 'N' && iterations < max_iterations) {
+        iterations += iterate_mpfr(z_real, z_imag, ca, cb, escape_radius_squared,
+                                   max_iterations - iterations, 0, escaped, period,
+                                   dz_real, dz_imag);
+    }
+    
+    return iterations;
+}
+
+/**
+ * Test c against the closed-form boundaries of the two largest hyperbolic
+ * components. Intermediates carry twice the precision of ca so that points
+ * within one ulp of the boundary are not misclassified by rounding.
+ */
+int interior_period(mpfr_t ca, mpfr_t cb) {
+    mpfr_prec_t prec = 2 * mpfr_get_prec(ca) + 8;
+    mpfr_t x, y_sq, q, t;
+    int period = 0;
+    
+    mpfr_init2(x, prec);
+    mpfr_init2(y_sq, prec);
+    mpfr_init2(q, prec);
+    mpfr_init2(t, prec);
+    
+    mpfr_sqr(y_sq, cb, MPFR_RNDN);
+    
+    // Main cardioid: q (q + x - 1/4) < y^2 / 4 with q = (x - 1/4)^2 + y^2
+    mpfr_sub_d(x, ca, 0.25, MPFR_RNDN);
+    mpfr_sqr(q, x, MPFR_RNDN);
+    mpfr_add(q, q, y_sq, MPFR_RNDN);
+    mpfr_add(t, q, x, MPFR_RNDN);
+    mpfr_mul(t, t, q, MPFR_RNDN);
+    mpfr_mul_2si(q, y_sq, -2, MPFR_RNDN);
+    if (mpfr_less_p(t, q)) {
+        period = 1;
+    } else {
+        // Period-2 disk: (x + 1)^2 + y^2 < 1/16
+        mpfr_add_ui(x, ca, 1, MPFR_RNDN);
+        mpfr_sqr(t, x, MPFR_RNDN);
+        mpfr_add(t, t, y_sq, MPFR_RNDN);
+        if (mpfr_cmp_d(t, 0.0625) < 0) {
+            period = 2;
+        }
+    }
+    
+    mpfr_clear(x);
+    mpfr_clear(y_sq);
+    mpfr_clear(q);
+    mpfr_clear(t);
+    
+    return period;
+}
+
+void exterior_distance(mpfr_t distance, mpfr_t z_real, mpfr_t z_imag,
+                       mpfr_t dz_real, mpfr_t dz_imag) {
+    mpfr_prec_t prec = mpfr_get_prec(distance);
+    mpfr_t z_abs, dz_abs, log_abs;
+    
+    mpfr_init2(z_abs, prec);
+    mpfr_init2(dz_abs, prec);
+    mpfr_init2(log_abs, prec);
+    
+    mpfr_hypot(z_abs, z_real, z_imag, MPFR_RNDN);
+    mpfr_hypot(dz_abs, dz_real, dz_imag, MPFR_RNDN);
+    mpfr_log(log_abs, z_abs, MPFR_RNDN);
+    mpfr_mul(distance, z_abs, log_abs, MPFR_RNDN);
+    mpfr_mul_2ui(distance, distance, 1, MPFR_RNDN);
+    mpfr_div(distance, distance, dz_abs, MPFR_RNDN);
+    
+    mpfr_clear(z_abs);
+    mpfr_clear(dz_abs);
+    mpfr_clear(log_abs);
+}
+
+double smooth_iterations(mpfr_t z_real, mpfr_t z_imag, long iterations) {
+    mpfr_t log_abs;
+    double smooth = (double)iterations;
+    
+    mpfr_init2(log_abs, DISTANCE_PRECISION);
+    mpfr_hypot(log_abs, z_real, z_imag, MPFR_RNDN);
+    mpfr_log(log_abs, log_abs, MPFR_RNDN);
+    if (mpfr_sgn(log_abs) > 0) {
+        mpfr_log2(log_abs, log_abs, MPFR_RNDN);
+        smooth += 1.0 - mpfr_get_d(log_abs, MPFR_RNDN);
+    }
+    
+    mpfr_clear(log_abs);
+    return smooth;
+}
+
+/**
+ * (re, im) = (a_re + i a_im)(b_re + i b_im); the result may alias either
+ * operand, t_re and t_im are scratch variables
+ */
+static void complex_mul(mpfr_t re, mpfr_t im, mpfr_t a_re, mpfr_t a_im,
+                        mpfr_t b_re, mpfr_t b_im, mpfr_t t_re, mpfr_t t_im) {
+    mpfr_fmms(t_re, a_re, b_re, a_im, b_im, MPFR_RNDN);
+    mpfr_fmma(t_im, a_re, b_im, a_im, b_re, MPFR_RNDN);
+    mpfr_swap(re, t_re);
+    mpfr_swap(im, t_im);
+}
+
+/**
+ * Follow the cycle once from a point of it, carrying the first derivatives
+ * dz/dz0 (a) and dz/dc (b) and the second derivatives d2z/dz0^2 (aa) and
+ * d2z/dc dz0 (ab), then evaluate
+ *   (1 - |a|^2) / |ab + aa b / (1 - a)|
+ */
+int interior_distance(mpfr_t distance, mpfr_t z_real, mpfr_t z_imag,
+                      mpfr_t ca, mpfr_t cb, long period) {
+    mpfr_prec_t prec = mpfr_get_prec(z_real);
+    mpfr_t x, y, a_re, a_im, b_re, b_im, aa_re, aa_im, ab_re, ab_im;
+    mpfr_t t_re, t_im, u_re, u_im, norm;
+    mpfr_ptr all[] = { x, y, a_re, a_im, b_re, b_im, aa_re, aa_im, ab_re, ab_im,
+                       t_re, t_im, u_re, u_im, norm };
+    size_t count = sizeof(all) / sizeof(all[0]);
+    int status = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        mpfr_init2(all[i], prec);
+        mpfr_set_zero(all[i], 1);
+    }
+    mpfr_set(x, z_real, MPFR_RNDN);
+    mpfr_set(y, z_imag, MPFR_RNDN);
+    mpfr_set_ui(a_re, 1, MPFR_RNDN);
+    
+    for (long i = 0; i < period; i++) {
+        // ab = 2 (z ab + a b) and aa = 2 (a^2 + z aa), from the old a and b
+        complex_mul(ab_re, ab_im, x, y, ab_re, ab_im, t_re, t_im);
+        complex_mul(u_re, u_im, a_re, a_im, b_re, b_im, t_re, t_im);
+        mpfr_add(ab_re, ab_re, u_re, MPFR_RNDN);
+        mpfr_add(ab_im, ab_im, u_im, MPFR_RNDN);
+        mpfr_mul_2ui(ab_re, ab_re, 1, MPFR_RNDN);
+        mpfr_mul_2ui(ab_im, ab_im, 1, MPFR_RNDN);
+        
+        complex_mul(aa_re, aa_im, x, y, aa_re, aa_im, t_re, t_im);
+        complex_mul(u_re, u_im, a_re, a_im, a_re, a_im, t_re, t_im);
+        mpfr_add(aa_re, aa_re, u_re, MPFR_RNDN);
+        mpfr_add(aa_im, aa_im, u_im, MPFR_RNDN);
+        mpfr_mul_2ui(aa_re, aa_re, 1, MPFR_RNDN);
+        mpfr_mul_2ui(aa_im, aa_im, 1, MPFR_RNDN);
+        
+        // a = 2 z a and b = 2 z b + 1
+        complex_mul(a_re, a_im, x, y, a_re, a_im, t_re, t_im);
+        mpfr_mul_2ui(a_re, a_re, 1, MPFR_RNDN);
+        mpfr_mul_2ui(a_im, a_im, 1, MPFR_RNDN);
+        complex_mul(b_re, b_im, x, y, b_re, b_im, t_re, t_im);
+        mpfr_mul_2ui(b_re, b_re, 1, MPFR_RNDN);
+        mpfr_mul_2ui(b_im, b_im, 1, MPFR_RNDN);
+        mpfr_add_ui(b_re, b_re, 1, MPFR_RNDN);
+        
+        // z = z^2 + c
+        complex_mul(x, y, x, y, x, y, t_re, t_im);
+        mpfr_add(x, x, ca, MPFR_RNDN);
+        mpfr_add(y, y, cb, MPFR_RNDN);
+    }
+    
+    // Numerator 1 - |a|^2, stored in norm
+    mpfr_fmma(norm, a_re, a_re, a_im, a_im, MPFR_RNDN);
+    mpfr_ui_sub(norm, 1, norm, MPFR_RNDN);
+    
+    // u = aa b / (1 - a) = aa b conj(1 - a) / |1 - a|^2
+    mpfr_ui_sub(a_re, 1, a_re, MPFR_RNDN);
+    mpfr_neg(a_im, a_im, MPFR_RNDN);
+    complex_mul(u_re, u_im, aa_re, aa_im, b_re, b_im, t_re, t_im);
+    mpfr_neg(a_im, a_im, MPFR_RNDN);
+    complex_mul(u_re, u_im, u_re, u_im, a_re, a_im, t_re, t_im);
+    mpfr_fmma(t_re, a_re, a_re, a_im, a_im, MPFR_RNDN);
+    mpfr_div(u_re, u_re, t_re, MPFR_RNDN);
+    mpfr_div(u_im, u_im, t_re, MPFR_RNDN);
+    
+    // Denominator |ab + u|
+    mpfr_add(u_re, u_re, ab_re, MPFR_RNDN);
+    mpfr_add(u_im, u_im, ab_im, MPFR_RNDN);
+    mpfr_hypot(t_im, u_re, u_im, MPFR_RNDN);
+    
+    if (mpfr_sgn(norm) <= 0 || !mpfr_regular_p(t_im)) {
+        // Not attracting at this precision
+        mpfr_set_zero(distance, 1);
+        status = -1;
+    } else {
+        mpfr_div(distance, norm, t_im, MPFR_RNDN);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        mpfr_clear(all[i]);
+    }
+    return status;
+}
+
+/**
+ * Principal square root (re, im) of (w_re, w_im) with re >= 0, taking the
+ * smaller of re and |im| from the larger to avoid cancellation
+ */
+static void complex_sqrt(mpfr_t re, mpfr_t im, mpfr_t w_re, mpfr_t w_im) {
+    mpfr_t r, s;
+    mpfr_init2(r, mpfr_get_prec(re));
+    mpfr_init2(s, mpfr_get_prec(re));
+    
+    // s = sqrt((|w| + |w_re|) / 2)
+    mpfr_hypot(r, w_re, w_im, MPFR_RNDN);
+    mpfr_abs(s, w_re, MPFR_RNDN);
+    mpfr_add(s, r, s, MPFR_RNDN);
+    mpfr_div_2ui(s, s, 1, MPFR_RNDN);
+    mpfr_sqrt(s, s, MPFR_RNDN);
+    
+    if (mpfr_zero_p(s)) {
+        mpfr_set_zero(re, 1);
+        mpfr_set_zero(im, 1);
+    } else if (mpfr_sgn(w_re) >= 0) {
+        // re = s, im = w_im / (2 s)
+        mpfr_div(im, w_im, s, MPFR_RNDN);
+        mpfr_div_2ui(im, im, 1, MPFR_RNDN);
+        mpfr_set(re, s, MPFR_RNDN);
+    } else {
+        // im = +-s with the sign of w_im, re = |w_im| / (2 s)
+        mpfr_abs(re, w_im, MPFR_RNDN);
+        mpfr_div(re, re, s, MPFR_RNDN);
+        mpfr_div_2ui(re, re, 1, MPFR_RNDN);
+        mpfr_setsign(im, s, mpfr_signbit(w_im), MPFR_RNDN);
+    }
+    
+    mpfr_clear(r);
+    mpfr_clear(s);
+}
+
+void interior_cycle_point(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb, int period) {
+    mpfr_prec_t prec = mpfr_get_prec(z_real);
+    mpfr_t w_re, w_im;
+    mpfr_init2(w_re, prec);
+    mpfr_init2(w_im, prec);
+    
+    // w = 1 - 4c for period 1, -3 - 4c for period 2
+    mpfr_mul_2ui(w_re, ca, 2, MPFR_RNDN);
+    mpfr_si_sub(w_re, period == 1 ? 1 : -3, w_re, MPFR_RNDN);
+    mpfr_mul_2ui(w_im, cb, 2, MPFR_RNDN);
+    mpfr_neg(w_im, w_im, MPFR_RNDN);
+    complex_sqrt(z_real, z_imag, w_re, w_im);
+    
+    // z = (1 - sqrt(w)) / 2 or (-1 + sqrt(w)) / 2
+    if (period == 1) {
+        mpfr_ui_sub(z_real, 1, z_real, MPFR_RNDN);
+        mpfr_neg(z_imag, z_imag, MPFR_RNDN);
+    } else {
+        mpfr_sub_ui(z_real, z_real, 1, MPFR_RNDN);
+    }
+    mpfr_div_2ui(z_real, z_real, 1, MPFR_RNDN);
+    mpfr_div_2ui(z_imag, z_imag, 1, MPFR_RNDN);
+    
+    mpfr_clear(w_re);
+    mpfr_clear(w_im);
+}
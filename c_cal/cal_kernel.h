@@ -0,0 +1,104 @@
+#ifndef CAL_KERNEL_H
+#define CAL_KERNEL_H
+
+#include <mpfr.h>
+
+/**
+ * Two orbit points closer than 2^(PERIOD_TOLERANCE_BITS - precision) in both
+ * coordinates are treated as equal by the periodicity check
+ */
+#define PERIOD_TOLERANCE_BITS 8
+
+/**
+ * Precision of the derivative dz/dc carried for distance estimates and of
+ * the estimates themselves. Only their magnitude matters, so they do not
+ * follow the precision of z.
+ */
+#define DISTANCE_PRECISION 64
+
+/**
+ * Iterate z = z^2 + c with MPFR at the precision of z_real.
+ *
+ * Updates (z_real, z_imag) in place for at most max_iterations steps,
+ * stopping early when |z|^2 > escape_radius_squared.
+ *
+ * @param verbose If non-zero, print a CAL_STEP line after every step
+ * @param escaped Set to 'Y' if the orbit escaped, 'P' if a cycle was
+ *                found, 'N' otherwise
+ * @param period  If not NULL, detect cycles with Brent's algorithm and store
+ *                the cycle length (0 if none was found); NULL disables the check
+ * @param dz_real If not NULL, the derivative dz/dc (dz_real, dz_imag) is
+ *                updated alongside z as dz = 2 z dz + 1; both are NULL or
+ *                neither
+ * @return Number of iterations performed
+ */
+long iterate_mpfr(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb,
+                  mpfr_t escape_radius_squared, long max_iterations,
+                  int verbose, char *escaped, long *period,
+                  mpfr_ptr dz_real, mpfr_ptr dz_imag);
+
+/**
+ * Iterate z = z^2 + c using hardware double, long double or __float128 when
+ * the precision of z_real equals their mantissa width (53, 64 or 113 bits on
+ * x86-64) and all inputs are inside a safe exponent range, MPFR otherwise.
+ * Arguments and result are the same as iterate_mpfr() without verbose output.
+ *
+ * Without period detection, z, the escape status and the iteration count
+ * are bit-identical to iterate_mpfr() at every precision. With period, this
+ * only holds when no hardware kernel returns early (a square close to
+ * underflow, or the derivative leaving its range): the MPFR finish then
+ * starts the periodicity check afresh, so PERIOD, the iteration count and z
+ * of a detected cycle can differ from a run in iterate_mpfr() alone. The
+ * derivative is carried in the same hardware type and only agrees to its
+ * rounding.
+ */
+long iterate_dispatch(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb,
+                      mpfr_t escape_radius_squared, long max_iterations,
+                      char *escaped, long *period,
+                      mpfr_ptr dz_real, mpfr_ptr dz_imag);
+
+/**
+ * Check whether c lies inside the main cardioid or the period-2 disk, where
+ * the orbit of z0 = 0 is attracted to a cycle and never escapes.
+ *
+ * @return 1 for the main cardioid, 2 for the period-2 disk, 0 otherwise
+ */
+int interior_period(mpfr_t ca, mpfr_t cb);
+
+/**
+ * Exterior distance estimate 2 |z| ln|z| / |dz/dc| of an escaped point,
+ * rounded to the precision of distance. By the Koebe 1/4 theorem no point of
+ * the Mandelbrot set lies within a quarter of it from c; the larger the
+ * escape radius, the closer the estimate gets to its limit.
+ */
+void exterior_distance(mpfr_t distance, mpfr_t z_real, mpfr_t z_imag,
+                       mpfr_t dz_real, mpfr_t dz_imag);
+
+/**
+ * Normalized iteration count n + 1 - log2(ln|z|) of a point that escaped
+ * after n iterations with final z, for smooth coloring. Computed at
+ * DISTANCE_PRECISION, so the exponent of z may exceed the range of a double;
+ * n itself if |z| <= 1, where the formula is undefined.
+ */
+double smooth_iterations(mpfr_t z_real, mpfr_t z_imag, long iterations);
+
+/**
+ * Interior distance estimate of a c whose orbit is attracted to a cycle of
+ * the given period through (z_real, z_imag), rounded to the precision of
+ * distance. No point of the boundary of the set lies within a quarter of it
+ * from c. The cycle is followed once at the precision of z_real.
+ *
+ * @return 0 on success, non-zero if the cycle is not attracting at this
+ *         precision, in which case distance is set to 0
+ */
+int interior_distance(mpfr_t distance, mpfr_t z_real, mpfr_t z_imag,
+                      mpfr_t ca, mpfr_t cb, long period);
+
+/**
+ * Set (z_real, z_imag) to a point of the attracting cycle of a c found by
+ * interior_period(): the fixed point (1 - sqrt(1 - 4c)) / 2 for period 1, or
+ * (-1 + sqrt(-3 - 4c)) / 2 for period 2. Computed at the precision of z_real.
+ */
+void interior_cycle_point(mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb, int period);
+
+#endif // CAL_KERNEL_H
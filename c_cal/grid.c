@@ -0,0 +1,70 @@
+#include "grid.h"
+#include <stdlib.h>
+
+/**
+ * Allocate and fill one axis: min + (max - min) * k / n for k < n
+ *
+ * @return The values, or NULL if memory could not be allocated
+ */
+static mpfr_t *make_axis(mpfr_t min, mpfr_t max, long n) {
+    mpfr_prec_t precision = mpfr_get_prec(min);
+    mpfr_t *axis = malloc(n * sizeof(mpfr_t));
+    if (axis == NULL) {
+        return NULL;
+    }
+
+    for (long k = 0; k < n; k++) {
+        mpfr_init2(axis[k], precision);
+        if (n > 1) {
+            mpfr_sub(axis[k], max, min, MPFR_RNDN);
+            mpfr_mul_si(axis[k], axis[k], k, MPFR_RNDN);
+            mpfr_div_si(axis[k], axis[k], n, MPFR_RNDN);
+            mpfr_add(axis[k], min, axis[k], MPFR_RNDN);
+        } else {
+            mpfr_set(axis[k], min, MPFR_RNDN);
+        }
+    }
+    return axis;
+}
+
+static void free_axis(mpfr_t *axis, long n) {
+    if (axis == NULL) {
+        return;
+    }
+    for (long k = 0; k < n; k++) {
+        mpfr_clear(axis[k]);
+    }
+    free(axis);
+}
+
+int grid_init(grid_t *grid, mpfr_t min_ca, mpfr_t max_ca, mpfr_t min_cb, mpfr_t max_cb,
+              long resolution_ca, long resolution_cb) {
+    grid->resolution_ca = resolution_ca;
+    grid->resolution_cb = resolution_cb;
+    grid->ca = make_axis(min_ca, max_ca, resolution_ca);
+    grid->cb = make_axis(min_cb, max_cb, resolution_cb);
+
+    if (grid->ca == NULL || grid->cb == NULL) {
+        grid_clear(grid);
+        return -1;
+    }
+    return 0;
+}
+
+int grid_point(const grid_t *grid, long x, long y, mpfr_t ca, mpfr_t cb) {
+    if (x < 0 || x >= grid->resolution_ca || y < 0 || y >= grid->resolution_cb) {
+        return -1;
+    }
+    mpfr_set(ca, grid->ca[x], MPFR_RNDN);
+    mpfr_set(cb, grid->cb[y], MPFR_RNDN);
+    return 0;
+}
+
+void grid_clear(grid_t *grid) {
+    free_axis(grid->ca, grid->resolution_ca);
+    free_axis(grid->cb, grid->resolution_cb);
+    grid->ca = NULL;
+    grid->cb = NULL;
+    grid->resolution_ca = 0;
+    grid->resolution_cb = 0;
+}
@@ -0,0 +1,42 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <mpfr.h>
+
+/**
+ * Regular grid of c values. Column x of resolution_ca lies at
+ * min_ca + (max_ca - min_ca) * x / resolution_ca (max excluded), and row y
+ * likewise along cb; an axis with a single point lies at its minimum.
+ *
+ * Every coordinate is computed once per axis from its integer offset, at
+ * the grid precision, so a pixel is addressed by (x, y) alone.
+ */
+typedef struct {
+    long resolution_ca;
+    long resolution_cb;
+    mpfr_t *ca;                 // Column values
+    mpfr_t *cb;                 // Row values
+} grid_t;
+
+/**
+ * Compute both axes at the precision of min_ca
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+int grid_init(grid_t *grid, mpfr_t min_ca, mpfr_t max_ca, mpfr_t min_cb, mpfr_t max_cb,
+              long resolution_ca, long resolution_cb);
+
+/**
+ * Set c of pixel (x, y), rounded to the precision of ca and cb. This gives
+ * the same value as parsing the base-32 text of the grid coordinate.
+ *
+ * @return 0 on success, non-zero if the pixel lies outside the grid
+ */
+int grid_point(const grid_t *grid, long x, long y, mpfr_t ca, mpfr_t cb);
+
+/**
+ * Release both axes; an empty grid is left behind
+ */
+void grid_clear(grid_t *grid);
+
+#endif // GRID_H
@@ -1,41 +1,264 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <mpfr.h>
 #include "mpfr_base32.h"
+#include "cal_kernel.h"
+#include "perturbation.h"
+#include "point_store.h"
+#include "grid.h"
+#include "orbit_file.h"
 
 #define MAX_LINE_LENGTH 4096
 
+/** Number of CAL points answered by the interior test since start-up */
+static long interior_points = 0;
+
+/** Undecided points kept by CAL_BATCH ... KEEP for CONTINUE and DROP */
+static point_store_t kept_points = { NULL, 0, 0 };
+
+/** Grid set by GRID, addressed by pixel in CAL_GRID */
+static grid_t active_grid = { 0, 0, NULL, NULL };
+
+/** Directory of the reference-orbit cache used by PERTURB, NULL if none */
+static char *orbit_cache_dir = NULL;
+
+/** Output buffers for the final z of each result line */
+static base32_buffer_t za_text = { NULL, 0 };
+static base32_buffer_t zb_text = { NULL, 0 };
+static base32_buffer_t distance_text = { NULL, 0 };
+
+/** Input buffer for the record lines of CAL_BATCH, CAL_GRID and PERTURB, grown by getline */
+static char *record_line = NULL;
+static size_t record_line_size = 0;
+
+/**
+ * Optional trailing flags of CAL and CAL_BATCH
+ */
+typedef struct {
+    int detect_period;      // PERIOD: stop on a detected cycle
+    int detect_interior;    // INTERIOR: closed-form cardioid and period-2 disk tests
+    int keep;               // KEEP: hold undecided points in memory (CAL_BATCH only)
+    int distance;           // DISTANCE: carry dz/dc and report distance estimates
+    int smooth;             // SMOOTH: report the normalized iteration count of escaped points
+    int short_z;            // SHORT_Z: print final z rounded to a double
+    int keep_z;             // KEEP_Z: answer kept points with the z they reached
+} cal_flags_t;
+
 /**
- * Complex number squaring: (a + bi)^2 = (a^2 - b^2) + (2ab)i
+ * Split line in place into up to max_fields whitespace-separated fields;
+ * anything after the last field is ignored
+ *
+ * @return Number of fields found
  */
-void complex_square(mpfr_t result_real, mpfr_t result_imag, mpfr_t real, mpfr_t imag) {
-    mpfr_t temp1, temp2, temp3;
-    mpfr_prec_t prec = mpfr_get_prec(real);
+static int split_fields(char *line, char **fields, int max_fields) {
+    int field_count = 0;
+    char *rest = line;
     
-    mpfr_init2(temp1, prec);
-    mpfr_init2(temp2, prec);
-    mpfr_init2(temp3, prec);
+    while (field_count < max_fields) {
+        rest += strspn(rest, " \t\r\n");
+        if (*rest == '\0') {
+            break;
+        }
+        fields[field_count++] = rest;
+        rest += strcspn(rest, " \t\r\n");
+        if (*rest != '\0') {
+            *rest++ = '\0';
+        }
+    }
+    return field_count;
+}
+
+/**
+ * Parse a whole field as a decimal integer
+ *
+ * @return 0 on success, -1 if the field is not an integer
+ */
+static int parse_long_field(const char *field, long *value) {
+    char *end;
     
-    // temp1 = real^2
-    mpfr_sqr(temp1, real, MPFR_RNDN);
+    errno = 0;
+    *value = strtol(field, &end, 10);
+    return (end == field || *end != '\0' || errno != 0) ? -1 : 0;
+}
+
+/**
+ * Parse the flags following the numeric parameters; unknown words are ignored
+ */
+static void parse_cal_flags(const char *flags, cal_flags_t *out) {
+    char flag_str[MAX_LINE_LENGTH];
+    int flag_length;
     
-    // temp2 = imag^2
-    mpfr_sqr(temp2, imag, MPFR_RNDN);
+    out->detect_period = 0;
+    out->detect_interior = 0;
+    out->keep = 0;
+    out->distance = 0;
+    out->smooth = 0;
+    out->short_z = 0;
+    out->keep_z = 0;
+    while (sscanf(flags, "%s%n", flag_str, &flag_length) == 1) {
+        if (strcmp(flag_str, "PERIOD") == 0) {
+            out->detect_period = 1;
+        } else if (strcmp(flag_str, "INTERIOR") == 0) {
+            out->detect_interior = 1;
+        } else if (strcmp(flag_str, "KEEP") == 0) {
+            out->keep = 1;
+        } else if (strcmp(flag_str, "DISTANCE") == 0) {
+            out->distance = 1;
+        } else if (strcmp(flag_str, "SMOOTH") == 0) {
+            out->smooth = 1;
+        } else if (strcmp(flag_str, "SHORT_Z") == 0) {
+            out->short_z = 1;
+        } else if (strcmp(flag_str, "KEEP_Z") == 0) {
+            out->keep_z = 1;
+        }
+        flags += flag_length;
+    }
+}
+
+/**
+ * Base-32 text of one part of final z, rounded to a double first if short_z
+ */
+static const char *final_z_text(mpfr_t value, int short_z, base32_buffer_t *buffer) {
+    if (!short_z || mpfr_get_prec(value) <= 53) {
+        return mpfr_to_base32_reuse(value, buffer);
+    }
+    mpfr_t rounded;
+    mpfr_init2(rounded, 53);
+    mpfr_set(rounded, value, MPFR_RNDN);
+    const char *text = mpfr_to_base32_reuse(rounded, buffer);
+    mpfr_clear(rounded);
+    return text;
+}
+
+/**
+ * Print a result line "<tag> <escaped> <final_za> <final_zb> <iterations> [<period>]
+ * [<distance>] [<smooth>]" without flushing; distance and smooth are left out
+ * if NULL. With short_z, final z is rounded to 53 bits.
+ */
+static void print_point_result(const char *tag, char escaped, mpfr_t z_real, mpfr_t z_imag,
+                               long iterations, long period, mpfr_ptr distance,
+                               const double *smooth, int short_z) {
+    char smooth_str[32] = "";
     
-    // temp3 = 2 * real * imag
-    mpfr_mul(temp3, real, imag, MPFR_RNDN);
-    mpfr_mul_si(temp3, temp3, 2, MPFR_RNDN);
+    // Convert results to base-32 strings
+    const char *final_za_str = final_z_text(z_real, short_z, &za_text);
+    const char *final_zb_str = final_z_text(z_imag, short_z, &zb_text);
+    const char *distance_str = (distance != NULL) ?
+        mpfr_to_base32_reuse(distance, &distance_text) : "";
+    const char *separator = (distance != NULL) ? " " : "";
+    if (smooth != NULL) {
+        snprintf(smooth_str, sizeof(smooth_str), " %.17g", *smooth);
+    }
     
-    // result_real = real^2 - imag^2
-    mpfr_sub(result_real, temp1, temp2, MPFR_RNDN);
+    if (final_za_str == NULL || final_zb_str == NULL || distance_str == NULL) {
+        printf("BAD_CMD\n");
+    } else if (escaped == 'P') {
+        printf("%s P %s %s %ld %ld%s%s%s\n", tag, final_za_str, final_zb_str, iterations, period,
+               separator, distance_str, smooth_str);
+    } else {
+        printf("%s %c %s %s %ld%s%s%s\n", tag, escaped, final_za_str, final_zb_str, iterations,
+               separator, distance_str, smooth_str);
+    }
+}
+
+/**
+ * Distance estimate of a decided point: exterior for an escaped point,
+ * interior for a periodic one (from a point of its cycle, computed in closed
+ * form if the interior test answered before any iteration)
+ */
+static void point_distance(mpfr_t distance, char escaped, int interior, mpfr_t z_real,
+                           mpfr_t z_imag, mpfr_t ca, mpfr_t cb, long period,
+                           mpfr_t dz_real, mpfr_t dz_imag) {
+    if (escaped == 'Y') {
+        exterior_distance(distance, z_real, z_imag, dz_real, dz_imag);
+    } else if (interior) {
+        mpfr_t cycle_real, cycle_imag;
+        mpfr_init2(cycle_real, mpfr_get_prec(z_real));
+        mpfr_init2(cycle_imag, mpfr_get_prec(z_real));
+        interior_cycle_point(cycle_real, cycle_imag, ca, cb, (int)period);
+        interior_distance(distance, cycle_real, cycle_imag, ca, cb, period);
+        mpfr_clear(cycle_real);
+        mpfr_clear(cycle_imag);
+    } else {
+        interior_distance(distance, z_real, z_imag, ca, cb, period);
+    }
+}
+
+/**
+ * Iterate one point from z = (z_real, z_imag) and print its result line
+ * without flushing. z is updated in place. With flags->keep, a point that
+ * is still undecided is reported as "<tag> K <iterations>" without z. With
+ * flags->distance, dz/dc (dz_real, dz_imag) is updated alongside z and
+ * decided points get their distance estimate; otherwise dz may be NULL.
+ * With flags->smooth, escaped points get their normalized iteration count,
+ * based on the iterations of this call.
+ *
+ * @return The escape status of the point
+ */
+static char run_point(const char *tag, mpfr_t z_real, mpfr_t z_imag, mpfr_t ca, mpfr_t cb,
+                      mpfr_t escape_radius_squared, long max_iterations, int verbose,
+                      const cal_flags_t *flags, mpfr_ptr dz_real, mpfr_ptr dz_imag) {
+    char escaped;
+    long iterations, period = 0;
+    long *period_ptr = flags->detect_period ? &period : NULL;
+    int interior = 0;
+    if (!flags->distance) {
+        dz_real = NULL;
+        dz_imag = NULL;
+    }
+    if (flags->detect_interior && mpfr_zero_p(z_real) && mpfr_zero_p(z_imag) &&
+        (period = interior_period(ca, cb)) != 0) {
+        // The orbit of 0 is attracted to a cycle of this length
+        escaped = 'P';
+        iterations = 0;
+        interior = 1;
+        interior_points++;
+    } else if (verbose) {
+        iterations = iterate_mpfr(z_real, z_imag, ca, cb, escape_radius_squared,
+                                  max_iterations, 1, &escaped, period_ptr, dz_real, dz_imag);
+    } else {
+        iterations = iterate_dispatch(z_real, z_imag, ca, cb, escape_radius_squared,
+                                      max_iterations, &escaped, period_ptr, dz_real, dz_imag);
+    }
     
-    // result_imag = 2 * real * imag
-    mpfr_set(result_imag, temp3, MPFR_RNDN);
+    if (flags->keep && escaped == 'N') {
+        if (flags->keep_z) {
+            // Always at full precision: z is where the point would resume
+            const char *za_str = mpfr_to_base32_reuse(z_real, &za_text);
+            const char *zb_str = mpfr_to_base32_reuse(z_imag, &zb_text);
+            if (za_str == NULL || zb_str == NULL) {
+                printf("%s BAD_CMD\n", tag);
+            } else {
+                printf("%s K %ld %s %s\n", tag, iterations, za_str, zb_str);
+            }
+        } else {
+            printf("%s K %ld\n", tag, iterations);
+        }
+        return escaped;
+    }
     
-    mpfr_clear(temp1);
-    mpfr_clear(temp2);
-    mpfr_clear(temp3);
+    double smooth = 0.0;
+    int report_smooth = flags->smooth && escaped == 'Y';
+    if (report_smooth) {
+        smooth = smooth_iterations(z_real, z_imag, iterations);
+    }
+    if (flags->distance && escaped != 'N') {
+        mpfr_t distance;
+        mpfr_init2(distance, DISTANCE_PRECISION);
+        point_distance(distance, escaped, interior, z_real, z_imag, ca, cb, period,
+                       dz_real, dz_imag);
+        print_point_result(tag, escaped, z_real, z_imag, iterations, period, distance,
+                           report_smooth ? &smooth : NULL, flags->short_z);
+        mpfr_clear(distance);
+    } else {
+        print_point_result(tag, escaped, z_real, z_imag, iterations, period, NULL,
+                           report_smooth ? &smooth : NULL, flags->short_z);
+    }
+    return escaped;
 }
 
 /**
@@ -59,9 +282,10 @@ void process_cal_command(const char *line, int verbose) {
         return;
     }
     
-    int parsed = sscanf(params_start, "%ld %s %s %s %s %ld %s",
+    int consumed = 0;
+    int parsed = sscanf(params_start, "%ld %s %s %s %s %ld %s%n",
                         &precision, za_str, zb_str, ca_str, cb_str,
-                        &max_iterations, escape_radius_str);
+                        &max_iterations, escape_radius_str, &consumed);
     
     if (parsed != 7 || precision <= 0 || max_iterations < 0) {
         printf("BAD_CMD\n");
@@ -69,10 +293,12 @@ void process_cal_command(const char *line, int verbose) {
         return;
     }
     
+    cal_flags_t flags;
+    parse_cal_flags(params_start + consumed, &flags);
+    
     // Initialize MPFR variables
     mpfr_t za, zb, ca, cb, escape_radius, escape_radius_squared;
-    mpfr_t z_real, z_imag, z_magnitude_squared;
-    mpfr_t temp_real, temp_imag;
+    mpfr_t z_real, z_imag, dz_real, dz_imag;
     
     mpfr_init2(za, precision);
     mpfr_init2(zb, precision);
@@ -82,9 +308,8 @@ void process_cal_command(const char *line, int verbose) {
     mpfr_init2(escape_radius_squared, precision);
     mpfr_init2(z_real, precision);
     mpfr_init2(z_imag, precision);
-    mpfr_init2(z_magnitude_squared, precision);
-    mpfr_init2(temp_real, precision);
-    mpfr_init2(temp_imag, precision);
+    mpfr_init2(dz_real, DISTANCE_PRECISION);
+    mpfr_init2(dz_imag, DISTANCE_PRECISION);
     
     // Parse input values
     if (parse_base32_to_mpfr(za_str, za, precision) != 0 ||
@@ -112,98 +337,610 @@ void process_cal_command(const char *line, int verbose) {
         mpfr_clear(escape_radius_squared);
         mpfr_clear(z_real);
         mpfr_clear(z_imag);
-        mpfr_clear(z_magnitude_squared);
-        mpfr_clear(temp_real);
-        mpfr_clear(temp_imag);
+        mpfr_clear(dz_real);
+        mpfr_clear(dz_imag);
         return;
     }
     
     // Pre-calculate escape_radius^2 for faster comparison
     mpfr_sqr(escape_radius_squared, escape_radius, MPFR_RNDN);
     
-    // Initialize z with z0
+    // Initialize z with z0; z0 is taken as independent of c, so dz/dc starts at 0
     mpfr_set(z_real, za, MPFR_RNDN);
     mpfr_set(z_imag, zb, MPFR_RNDN);
+    mpfr_set_zero(dz_real, 1);
+    mpfr_set_zero(dz_imag, 1);
     
-    // Perform iterations
-    long iterations = 0;
-    char escaped = 'N';
+    // Perform iterations and report
+    run_point("CAL", z_real, z_imag, ca, cb, escape_radius_squared,
+              max_iterations, verbose, &flags, dz_real, dz_imag);
+    fflush(stdout);
     
-    for (long i = 0; i < max_iterations; i++) {
-        // z = z^2 + c
-        complex_square(temp_real, temp_imag, z_real, z_imag);
-        mpfr_add(z_real, temp_real, ca, MPFR_RNDN);
-        mpfr_add(z_imag, temp_imag, cb, MPFR_RNDN);
-        
-        iterations = i + 1;
+    // Clean up
+    mpfr_clear(za);
+    mpfr_clear(zb);
+    mpfr_clear(ca);
+    mpfr_clear(cb);
+    mpfr_clear(escape_radius);
+    mpfr_clear(escape_radius_squared);
+    mpfr_clear(z_real);
+    mpfr_clear(z_imag);
+    mpfr_clear(dz_real);
+    mpfr_clear(dz_imag);
+}
+
+/**
+ * Parse a base-32 string that must hold a finite number
+ *
+ * @return 0 on success, non-zero on error
+ */
+static int parse_finite_base32(const char *str, mpfr_t value, mpfr_prec_t precision) {
+    if (parse_base32_to_mpfr(str, value, precision) != 0) {
+        return -1;
+    }
+    return (mpfr_nan_p(value) || mpfr_inf_p(value)) ? -1 : 0;
+}
+
+/**
+ * Print one result line with z rounded to the given precision
+ */
+static void print_ld_result(char escaped, long double z_real, long double z_imag,
+                            long iterations, mpfr_prec_t precision) {
+    mpfr_t value;
+    mpfr_init2(value, precision);
+
+    mpfr_set_ld(value, z_real, MPFR_RNDN);
+    const char *za_str = mpfr_to_base32_reuse(value, &za_text);
+    mpfr_set_ld(value, z_imag, MPFR_RNDN);
+    const char *zb_str = mpfr_to_base32_reuse(value, &zb_text);
+
+    if (za_str == NULL || zb_str == NULL) {
+        printf("BAD_CMD\n");
+    } else {
+        printf("CAL %c %s %s %ld\n", escaped, za_str, zb_str, iterations);
+    }
+
+    mpfr_clear(value);
+}
+
+/**
+ * Process CAL_ORBIT command
+ *
+ * CAL_ORBIT <precision> <za> <zb> <ca> <cb> <max_iterations> <escape_radius> <path>
+ * [EVERY <n>] [EXTENDED]
+ * iterates like CAL_VERBOSE, always with MPFR, but writes the orbit to the
+ * binary file (or named pipe) at <path> instead of printing CAL_STEP lines:
+ * z0, every n-th z and the final z, as doubles or, with EXTENDED, as
+ * mantissa and exponent pairs (see orbit_file.h). Once the file is closed,
+ * answers with the result line of CAL tagged CAL_ORBIT, or BAD_CMD if the
+ * parameters are invalid or the file cannot be written.
+ */
+void process_cal_orbit_command(const char *line) {
+    char za_str[MAX_LINE_LENGTH], zb_str[MAX_LINE_LENGTH];
+    char ca_str[MAX_LINE_LENGTH], cb_str[MAX_LINE_LENGTH];
+    char escape_radius_str[MAX_LINE_LENGTH], path[MAX_LINE_LENGTH];
+    char option_str[MAX_LINE_LENGTH];
+    long precision, max_iterations, every = 1;
+    orbit_format_t format = ORBIT_FORMAT_DOUBLE;
+    int consumed = 0, option_length;
+    
+    int parsed = sscanf(line + 10, "%ld %s %s %s %s %ld %s %s%n",
+                        &precision, za_str, zb_str, ca_str, cb_str,
+                        &max_iterations, escape_radius_str, path, &consumed);
+    int valid = (parsed == 8 && precision > 0 && max_iterations >= 0);
+    
+    // Options; unknown words are ignored as for the CAL flags
+    const char *options = line + 10 + consumed;
+    while (valid && sscanf(options, "%s%n", option_str, &option_length) == 1) {
+        options += option_length;
+        if (strcmp(option_str, "EXTENDED") == 0) {
+            format = ORBIT_FORMAT_EXTENDED;
+        } else if (strcmp(option_str, "EVERY") == 0) {
+            valid = sscanf(options, "%ld%n", &every, &option_length) == 1 &&
+                every >= 1 && every <= UINT32_MAX;
+            options += option_length;
+        }
+    }
+    if (!valid) {
+        printf("BAD_CMD\n");
+        fflush(stdout);
+        return;
+    }
+    
+    mpfr_t z_real, z_imag, ca, cb, escape_radius, escape_radius_squared;
+    mpfr_init2(z_real, precision);
+    mpfr_init2(z_imag, precision);
+    mpfr_init2(ca, precision);
+    mpfr_init2(cb, precision);
+    mpfr_init2(escape_radius, precision);
+    mpfr_init2(escape_radius_squared, precision);
+    
+    orbit_writer_t writer;
+    valid = parse_finite_base32(za_str, z_real, precision) == 0 &&
+        parse_finite_base32(zb_str, z_imag, precision) == 0 &&
+        parse_finite_base32(ca_str, ca, precision) == 0 &&
+        parse_finite_base32(cb_str, cb, precision) == 0 &&
+        parse_finite_base32(escape_radius_str, escape_radius, precision) == 0 &&
+        mpfr_cmp_si(escape_radius, 0) >= 0 &&
+        orbit_writer_open(&writer, path, format, every, precision, max_iterations) == 0;
+    
+    if (valid) {
+        mpfr_sqr(escape_radius_squared, escape_radius, MPFR_RNDN);
+        char escaped = 'N';
+        long iterations = 0;
+        int failed = orbit_writer_write(&writer, 0, z_real, z_imag);
         
-        // Output verbose step information if requested
-        if (verbose) {
-            char *step_za_str = mpfr_to_base32(z_real);
-            char *step_zb_str = mpfr_to_base32(z_imag);
-            if (step_za_str != NULL && step_zb_str != NULL) {
-                printf("CAL_STEP %s %s %ld\n", step_za_str, step_zb_str, iterations);
-                fflush(stdout);
+        // Each run stops at the next multiple of every, at the limit or on escape,
+        // and the kernel resumes bit-identically from z
+        while (!failed && escaped == 'N' && iterations < max_iterations) {
+            long steps = every - iterations % every;
+            if (steps > max_iterations - iterations) {
+                steps = max_iterations - iterations;
             }
-            if (step_za_str) free(step_za_str);
-            if (step_zb_str) free(step_zb_str);
+            iterations += iterate_mpfr(z_real, z_imag, ca, cb, escape_radius_squared, steps,
+                                       0, &escaped, NULL, NULL, NULL);
+            failed = orbit_writer_write(&writer, iterations, z_real, z_imag);
         }
         
-        // Check if |z|^2 > escape_radius^2 (faster than computing sqrt)
-        mpfr_sqr(temp_real, z_real, MPFR_RNDN);
-        mpfr_sqr(temp_imag, z_imag, MPFR_RNDN);
-        mpfr_add(z_magnitude_squared, temp_real, temp_imag, MPFR_RNDN);
-        
-        if (mpfr_cmp(z_magnitude_squared, escape_radius_squared) > 0) {
-            escaped = 'Y';
-            break;
+        if (orbit_writer_close(&writer) != 0 || failed) {
+            printf("BAD_CMD\n");
+        } else {
+            print_point_result("CAL_ORBIT", escaped, z_real, z_imag, iterations, 0, NULL,
+                               NULL, 0);
         }
+    } else {
+        printf("BAD_CMD\n");
     }
+    fflush(stdout);
     
-    // Convert results to base-32 strings
-    char *final_za_str = mpfr_to_base32(z_real);
-    char *final_zb_str = mpfr_to_base32(z_imag);
+    mpfr_clear(z_real);
+    mpfr_clear(z_imag);
+    mpfr_clear(ca);
+    mpfr_clear(cb);
+    mpfr_clear(escape_radius);
+    mpfr_clear(escape_radius_squared);
+}
+
+/**
+ * Process CAL_BATCH and CAL_GRID commands
+ *
+ * CAL_BATCH <precision> <max_iterations> <escape_radius> <count> [PERIOD] [INTERIOR] [KEEP]
+ * [DISTANCE] [SMOOTH] [SHORT_Z] [KEEP_Z]
+ * followed by <count> lines of "<id> <za> <zb> <ca> <cb>". Each record is
+ * answered in order with "RES <id> ..." carrying the fields of a CAL result,
+ * or "RES <id> BAD_CMD" if the record is invalid. Output is flushed once at
+ * the end of the batch.
+ *
+ * CAL_GRID takes the same header followed by <count> lines of
+ * "<id> <x> <y> [<za> <zb>]": each record starts at z0 (0 if not given) with
+ * c taken from pixel (x, y) of the grid set by GRID. Records outside the grid
+ * are answered with "RES <id> BAD_CMD".
+ *
+ * With KEEP, records that neither escape nor become periodic are answered
+ * with "RES <id> K <iterations>" and their state is kept under <id> for
+ * CONTINUE and DROP. With KEEP_Z as well, the answer is
+ * "RES <id> K <iterations> <za> <zb>" with z at full precision, here and in
+ * every CONTINUE of the point.
+ */
+void process_cal_batch_command(const char *line) {
+    char escape_radius_str[MAX_LINE_LENGTH];
+    char *fields[5];
+    char tag[MAX_LINE_LENGTH + 8];
+    long precision, max_iterations, count;
+    long x, y;
+    int consumed = 0;
+
+    // Parse the header - skip "CAL_BATCH " or "CAL_GRID " prefix
+    int grid_records = (strncmp(line, "CAL_GRID ", 9) == 0);
+    const char *params_start = line + (grid_records ? 9 : 10);
+
+    int parsed = sscanf(params_start, "%ld %ld %s %ld%n",
+                        &precision, &max_iterations, escape_radius_str, &count, &consumed);
+
+    // Without a valid count the records cannot be skipped either
+    if (parsed != 4 || count < 0) {
+        printf("BAD_CMD\n");
+        fflush(stdout);
+        return;
+    }
+
+    cal_flags_t flags;
+    parse_cal_flags(params_start + consumed, &flags);
+
+    int valid = (precision > 0 && max_iterations >= 0 &&
+                 (!grid_records || active_grid.resolution_ca > 0));
+    mpfr_prec_t prec = valid ? precision : MPFR_PREC_MIN;
+
+    mpfr_t escape_radius, escape_radius_squared, z_real, z_imag, ca, cb, dz_real, dz_imag;
+    mpfr_init2(escape_radius, prec);
+    mpfr_init2(escape_radius_squared, prec);
+    mpfr_init2(z_real, prec);
+    mpfr_init2(z_imag, prec);
+    mpfr_init2(ca, prec);
+    mpfr_init2(cb, prec);
+    mpfr_init2(dz_real, DISTANCE_PRECISION);
+    mpfr_init2(dz_imag, DISTANCE_PRECISION);
+
+    valid = valid &&
+        parse_finite_base32(escape_radius_str, escape_radius, prec) == 0 &&
+        mpfr_cmp_si(escape_radius, 0) >= 0;
+    if (valid) {
+        mpfr_sqr(escape_radius_squared, escape_radius, MPFR_RNDN);
+    } else {
+        printf("BAD_CMD\n");
+    }
+
+    // Always consume the records so the stream stays in sync. Records are
+    // read whole, however long their z0 at the batch precision is.
+    for (long i = 0; i < count; i++) {
+        if (getline(&record_line, &record_line_size, stdin) == -1) {
+            break;
+        }
+        if (!valid) {
+            continue;
+        }
+        int field_count = split_fields(record_line, fields, 5);
+        const char *id_str = field_count > 0 ? fields[0] : "-";
+        int record_valid = strlen(id_str) < MAX_LINE_LENGTH;
+        if (grid_records) {
+            // z0 is optional and defaults to 0
+            mpfr_set_zero(z_real, 1);
+            mpfr_set_zero(z_imag, 1);
+            record_valid = record_valid && (field_count == 3 || field_count == 5) &&
+                parse_long_field(fields[1], &x) == 0 &&
+                parse_long_field(fields[2], &y) == 0 &&
+                grid_point(&active_grid, x, y, ca, cb) == 0 &&
+                (field_count == 3 || (parse_finite_base32(fields[3], z_real, prec) == 0 &&
+                                      parse_finite_base32(fields[4], z_imag, prec) == 0));
+        } else {
+            record_valid = record_valid && field_count == 5 &&
+                parse_finite_base32(fields[1], z_real, prec) == 0 &&
+                parse_finite_base32(fields[2], z_imag, prec) == 0 &&
+                parse_finite_base32(fields[3], ca, prec) == 0 &&
+                parse_finite_base32(fields[4], cb, prec) == 0;
+        }
+        if (!record_valid) {
+            printf("RES %s BAD_CMD\n", id_str);
+            continue;
+        }
+        snprintf(tag, sizeof(tag), "RES %s", id_str);
+        mpfr_set_zero(dz_real, 1);
+        mpfr_set_zero(dz_imag, 1);
+        char escaped = run_point(tag, z_real, z_imag, ca, cb, escape_radius_squared,
+                                 max_iterations, 0, &flags, dz_real, dz_imag);
+        
+        if (flags.keep && escaped == 'N') {
+            stored_point_t *point = point_store_add(&kept_points, id_str, prec);
+            if (point == NULL) {
+                fprintf(stderr, "Failed to keep point %s\n", id_str);
+                continue;
+            }
+            mpfr_set(point->z_real, z_real, MPFR_RNDN);
+            mpfr_set(point->z_imag, z_imag, MPFR_RNDN);
+            mpfr_set(point->ca, ca, MPFR_RNDN);
+            mpfr_set(point->cb, cb, MPFR_RNDN);
+            mpfr_set(point->escape_radius_squared, escape_radius_squared, MPFR_RNDN);
+            mpfr_set(point->dz_real, dz_real, MPFR_RNDN);
+            mpfr_set(point->dz_imag, dz_imag, MPFR_RNDN);
+            point->detect_period = flags.detect_period;
+            point->track_distance = flags.distance;
+            point->report_smooth = flags.smooth;
+            point->short_z = flags.short_z;
+            point->report_z = flags.keep_z;
+        } else {
+            // A new result for this id supersedes any state kept earlier
+            point_store_remove(&kept_points, id_str);
+        }
+    }
+    fflush(stdout);
+
+    mpfr_clear(escape_radius);
+    mpfr_clear(escape_radius_squared);
+    mpfr_clear(z_real);
+    mpfr_clear(z_imag);
+    mpfr_clear(ca);
+    mpfr_clear(cb);
+    mpfr_clear(dz_real);
+    mpfr_clear(dz_imag);
+}
+
+/**
+ * Process GRID command
+ *
+ * GRID <grid_precision> <min_ca> <min_cb> <max_ca> <max_cb> <resolution_ca> <resolution_cb>
+ * sets the grid used by CAL_GRID and answers "GRID OK". The bounds are
+ * parsed and the coordinates computed at <grid_precision>, as the base-32
+ * text of each coordinate would be. An invalid command leaves the previous
+ * grid in place. The line is split in place, so bounds of any length are
+ * accepted.
+ */
+void process_grid_command(char *line) {
+    char *fields[7];
+    char **bound_str = fields + 1;
+    long precision, resolution_ca, resolution_cb;
     
-    if (final_za_str == NULL || final_zb_str == NULL) {
+    int parsed = split_fields(line + 5, fields, 7);
+    if (parsed != 7 ||
+        parse_long_field(fields[0], &precision) != 0 ||
+        parse_long_field(fields[5], &resolution_ca) != 0 ||
+        parse_long_field(fields[6], &resolution_cb) != 0 ||
+        precision <= 0 || resolution_ca < 1 || resolution_cb < 1) {
         printf("BAD_CMD\n");
         fflush(stdout);
+        return;
+    }
+    
+    // Bounds in protocol order: min_ca min_cb max_ca max_cb
+    mpfr_t bound[4];
+    int valid = 1;
+    for (int i = 0; i < 4; i++) {
+        mpfr_init2(bound[i], precision);
+        if (parse_finite_base32(bound_str[i], bound[i], precision) != 0) {
+            valid = 0;
+        }
+    }
+    
+    if (!valid) {
+        printf("BAD_CMD\n");
     } else {
-        printf("CAL %c %s %s %ld\n", escaped, final_za_str, final_zb_str, iterations);
+        grid_clear(&active_grid);
+        if (grid_init(&active_grid, bound[0], bound[2], bound[1], bound[3],
+                      resolution_ca, resolution_cb) != 0) {
+            printf("BAD_CMD\n");
+        } else {
+            printf("GRID OK\n");
+        }
+    }
+    fflush(stdout);
+    
+    for (int i = 0; i < 4; i++) {
+        mpfr_clear(bound[i]);
+    }
+}
+
+/**
+ * Process CONTINUE command
+ *
+ * CONTINUE <id> <more_iterations> resumes a point kept by CAL_BATCH ... KEEP
+ * and answers like CAL_BATCH: "RES <id> K <iterations>" while the point is
+ * still undecided, or the full result once it escapes or becomes periodic,
+ * at which point its state is released. <iterations> counts this command only,
+ * and so does the base of a SMOOTH value.
+ */
+void process_continue_command(const char *line) {
+    char id_str[MAX_LINE_LENGTH];
+    char tag[MAX_LINE_LENGTH + 8];
+    long more_iterations;
+    
+    if (sscanf(line + 9, "%s %ld", id_str, &more_iterations) != 2 || more_iterations < 0) {
+        printf("BAD_CMD\n");
         fflush(stdout);
+        return;
     }
     
-    // Clean up
-    if (final_za_str) free(final_za_str);
-    if (final_zb_str) free(final_zb_str);
+    stored_point_t *point = point_store_find(&kept_points, id_str);
+    if (point == NULL) {
+        printf("RES %s BAD_CMD\n", id_str);
+        fflush(stdout);
+        return;
+    }
     
-    mpfr_clear(za);
-    mpfr_clear(zb);
-    mpfr_clear(ca);
-    mpfr_clear(cb);
+    cal_flags_t flags = { point->detect_period, 0, 1, point->track_distance,
+                          point->report_smooth, point->short_z, point->report_z };
+    snprintf(tag, sizeof(tag), "RES %s", id_str);
+    char escaped = run_point(tag, point->z_real, point->z_imag, point->ca, point->cb,
+                             point->escape_radius_squared, more_iterations, 0, &flags,
+                             point->dz_real, point->dz_imag);
+    if (escaped != 'N') {
+        point_store_remove(&kept_points, id_str);
+    }
+    fflush(stdout);
+}
+
+/**
+ * Process DROP command
+ *
+ * DROP <id> releases a kept point and answers "RES <id> N <final_za> <final_zb> 0"
+ * with the z it had reached.
+ */
+void process_drop_command(const char *line) {
+    char id_str[MAX_LINE_LENGTH];
+    char tag[MAX_LINE_LENGTH + 8];
+    
+    if (sscanf(line + 5, "%s", id_str) != 1) {
+        printf("BAD_CMD\n");
+        fflush(stdout);
+        return;
+    }
+    
+    stored_point_t *point = point_store_find(&kept_points, id_str);
+    if (point == NULL) {
+        printf("RES %s BAD_CMD\n", id_str);
+    } else {
+        snprintf(tag, sizeof(tag), "RES %s", id_str);
+        print_point_result(tag, 'N', point->z_real, point->z_imag, 0, 0, NULL, NULL,
+                           point->short_z);
+        point_store_remove(&kept_points, id_str);
+    }
+    fflush(stdout);
+}
+
+/**
+ * Process PERTURB command
+ *
+ * PERTURB <precision> <ref_ca> <ref_cb> <max_iterations> <escape_radius> <count> [SA|BLA]
+ * followed by <count> lines of "<ca> <cb>". Every pixel starts at z0 = 0.
+ * With SA, a series approximation skips the first iterations of every pixel;
+ * with BLA, pixels jump over blocks of iterations using bilinear approximations.
+ */
+void process_perturb_command(const char *line) {
+    char ref_ca_str[MAX_LINE_LENGTH], ref_cb_str[MAX_LINE_LENGTH];
+    char escape_radius_str[MAX_LINE_LENGTH];
+    char mode_str[MAX_LINE_LENGTH];
+    char *fields[2];
+    long precision, max_iterations, count;
+    perturb_mode_t mode = PERTURB_PLAIN;
+
+    int parsed = sscanf(line + 8, "%ld %s %s %ld %s %ld %s",
+                        &precision, ref_ca_str, ref_cb_str, &max_iterations,
+                        escape_radius_str, &count, mode_str);
+
+    // Without a valid count the pixel lines cannot be skipped either
+    if (parsed < 6 || count < 0) {
+        printf("BAD_CMD\n");
+        fflush(stdout);
+        return;
+    }
+
+    perturb_pixel_t *pixels = malloc((count > 0 ? count : 1) * sizeof(perturb_pixel_t));
+    int valid = (pixels != NULL && precision > 0 && max_iterations >= 0);
+
+    if (parsed == 7) {
+        if (strcmp(mode_str, "SA") == 0) {
+            mode = PERTURB_SERIES;
+        } else if (strcmp(mode_str, "BLA") == 0) {
+            mode = PERTURB_BLA;
+        } else {
+            valid = 0;
+        }
+    }
+
+    mpfr_t ref_ca, ref_cb, escape_radius, escape_radius_squared, ca, cb;
+    mpfr_prec_t prec = valid ? precision : MPFR_PREC_MIN;
+    mpfr_init2(ref_ca, prec);
+    mpfr_init2(ref_cb, prec);
+    mpfr_init2(escape_radius, prec);
+    mpfr_init2(escape_radius_squared, prec);
+    mpfr_init2(ca, prec);
+    mpfr_init2(cb, prec);
+
+    valid = valid &&
+        parse_finite_base32(ref_ca_str, ref_ca, prec) == 0 &&
+        parse_finite_base32(ref_cb_str, ref_cb, prec) == 0 &&
+        parse_finite_base32(escape_radius_str, escape_radius, prec) == 0 &&
+        mpfr_cmp_si(escape_radius, 0) >= 0;
+
+    // Always consume the pixel lines so the stream stays in sync
+    for (long i = 0; i < count; i++) {
+        if (getline(&record_line, &record_line_size, stdin) == -1) {
+            valid = 0;
+            break;
+        }
+        if (!valid) {
+            continue;
+        }
+        if (split_fields(record_line, fields, 2) != 2 ||
+            parse_finite_base32(fields[0], ca, prec) != 0 ||
+            parse_finite_base32(fields[1], cb, prec) != 0) {
+            valid = 0;
+            continue;
+        }
+        mpfr_sub(ca, ca, ref_ca, MPFR_RNDN);
+        mpfr_sub(cb, cb, ref_cb, MPFR_RNDN);
+        pixels[i].dc_real = mpfr_get_ld(ca, MPFR_RNDN);
+        pixels[i].dc_imag = mpfr_get_ld(cb, MPFR_RNDN);
+    }
+
+    perturb_stats_t stats;
+    if (valid) {
+        mpfr_sqr(escape_radius_squared, escape_radius, MPFR_RNDN);
+        valid = perturb_tile(ref_ca, ref_cb, escape_radius_squared, max_iterations,
+                             mode, orbit_cache_dir, pixels, count, &stats) == 0;
+    }
+
+    if (valid) {
+        for (long i = 0; i < count; i++) {
+            print_ld_result(pixels[i].escaped, pixels[i].z_real, pixels[i].z_imag,
+                            pixels[i].iterations, prec);
+        }
+        if (mode == PERTURB_SERIES) {
+            mpfr_t error_bound;
+            mpfr_init2(error_bound, 53);
+            mpfr_set_ld(error_bound, stats.error_bound, MPFR_RNDU);
+            char *error_str = mpfr_to_base32(error_bound);
+            printf("SA %ld %s\n", stats.skipped, error_str ? error_str : "@NaN@");
+            if (error_str) free(error_str);
+            mpfr_clear(error_bound);
+        }
+        if (mode == PERTURB_BLA) {
+            printf("BLA %ld %ld\n", stats.bla_skipped, stats.bla_stepped);
+        }
+        printf("PERTURB %ld %ld %ld\n", stats.references, stats.rereferenced, stats.fallback);
+    } else {
+        printf("BAD_CMD\n");
+    }
+    fflush(stdout);
+
+    free(pixels);
+    mpfr_clear(ref_ca);
+    mpfr_clear(ref_cb);
     mpfr_clear(escape_radius);
     mpfr_clear(escape_radius_squared);
-    mpfr_clear(z_real);
-    mpfr_clear(z_imag);
-    mpfr_clear(z_magnitude_squared);
-    mpfr_clear(temp_real);
-    mpfr_clear(temp_imag);
+    mpfr_clear(ca);
+    mpfr_clear(cb);
+}
+
+/**
+ * Process ORBIT_CACHE command
+ *
+ * ORBIT_CACHE <dir> makes PERTURB take its first reference orbit from the
+ * cache in <dir> (see orbit_cache.h), creating the directory if needed, and
+ * answers "ORBIT_CACHE OK". ORBIT_CACHE OFF goes back to computing every
+ * orbit. A directory that cannot be used is answered with BAD_CMD and leaves
+ * the previous setting in place.
+ */
+void process_orbit_cache_command(const char *line) {
+    char dir[MAX_LINE_LENGTH];
+    struct stat st;
+    
+    if (sscanf(line + 12, "%s", dir) != 1) {
+        printf("BAD_CMD\n");
+    } else if (strcmp(dir, "OFF") == 0) {
+        free(orbit_cache_dir);
+        orbit_cache_dir = NULL;
+        printf("ORBIT_CACHE OK\n");
+    } else if ((mkdir(dir, 0777) != 0 && errno != EEXIST) ||
+               stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || access(dir, W_OK) != 0) {
+        printf("BAD_CMD\n");
+    } else {
+        free(orbit_cache_dir);
+        orbit_cache_dir = strdup(dir);
+        printf(orbit_cache_dir != NULL ? "ORBIT_CACHE OK\n" : "BAD_CMD\n");
+    }
+    fflush(stdout);
 }
 
 /**
  * Main function
  */
 int main() {
-    char line[MAX_LINE_LENGTH];
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
     
-    while (fgets(line, sizeof(line), stdin) != NULL) {
+    while ((len = getline(&line, &line_size, stdin)) != -1) {
         // Remove trailing newline
-        size_t len = strlen(line);
         if (len > 0 && line[len - 1] == '\n') {
-            line[len - 1] = '\0';
+            line[--len] = '\0';
+        }
+        
+        // Only GRID splits its line in place; every other command parses
+        // into fields of MAX_LINE_LENGTH, so longer lines are refused whole
+        if (len >= MAX_LINE_LENGTH && strncmp(line, "GRID ", 5) != 0) {
+            printf("BAD_CMD\n");
+            fflush(stdout);
+            continue;
         }
         
         // Check for EXIT command
         if (strcmp(line, "EXIT") == 0) {
+            point_store_clear(&kept_points);
+            grid_clear(&active_grid);
+            free(orbit_cache_dir);
+            free(za_text.data);
+            free(zb_text.data);
+            free(distance_text.data);
+            free(record_line);
             printf("EXIT\n");
             fflush(stdout);
             break;
@@ -213,14 +950,47 @@ int main() {
         if (strncmp(line, "CAL_VERBOSE ", 12) == 0) {
             process_cal_command(line, 1);
         }
+        // Check for CAL_ORBIT command
+        else if (strncmp(line, "CAL_ORBIT ", 10) == 0) {
+            process_cal_orbit_command(line);
+        }
+        // Check for CAL_BATCH and CAL_GRID commands
+        else if (strncmp(line, "CAL_BATCH ", 10) == 0 || strncmp(line, "CAL_GRID ", 9) == 0) {
+            process_cal_batch_command(line);
+        }
+        // Check for GRID command
+        else if (strncmp(line, "GRID ", 5) == 0) {
+            process_grid_command(line);
+        }
         // Check for CAL command
         else if (strncmp(line, "CAL ", 4) == 0) {
             process_cal_command(line, 0);
+        }
+        // Check for CONTINUE and DROP commands on kept points
+        else if (strncmp(line, "CONTINUE ", 9) == 0) {
+            process_continue_command(line);
+        }
+        else if (strncmp(line, "DROP ", 5) == 0) {
+            process_drop_command(line);
+        }
+        // Check for PERTURB command
+        else if (strncmp(line, "PERTURB ", 8) == 0) {
+            process_perturb_command(line);
+        }
+        // Check for ORBIT_CACHE command
+        else if (strncmp(line, "ORBIT_CACHE ", 12) == 0) {
+            process_orbit_cache_command(line);
+        }
+        // Report per-run counters
+        else if (strcmp(line, "STATS") == 0) {
+            printf("STATS %ld\n", interior_points);
+            fflush(stdout);
         } else {
             printf("BAD_CMD\n");
             fflush(stdout);
         }
     }
     
+    free(line);
     return 0;
 }
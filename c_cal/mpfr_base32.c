@@ -3,140 +3,359 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define DIGIT_BITS 5  // 32 = 2^5
+
+static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuv";
+
+/**
+ * Digit value plus one for each base-32 character, zero for anything else
+ */
+static const signed char digit_table[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5, ['5'] = 6, ['6'] = 7, ['7'] = 8,
+    ['8'] = 9, ['9'] = 10, ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['g'] = 17, ['h'] = 18, ['i'] = 19, ['j'] = 20, ['k'] = 21, ['l'] = 22, ['m'] = 23, ['n'] = 24,
+    ['o'] = 25, ['p'] = 26, ['q'] = 27, ['r'] = 28, ['s'] = 29, ['t'] = 30, ['u'] = 31, ['v'] = 32,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16, ['G'] = 17, ['H'] = 18,
+    ['I'] = 19, ['J'] = 20, ['K'] = 21, ['L'] = 22, ['M'] = 23, ['N'] = 24, ['O'] = 25, ['P'] = 26,
+    ['Q'] = 27, ['R'] = 28, ['S'] = 29, ['T'] = 30, ['U'] = 31, ['V'] = 32,
+};
+
+/**
+ * Value of a base-32 digit character, or -1 if it is not one
+ */
+static int digit_value(char c) {
+    return digit_table[(unsigned char)c] - 1;
+}
+
+/**
+ * Number of limbs holding the significand of a number with this precision
+ */
+static size_t limb_count(mpfr_prec_t prec) {
+    return (size_t)((prec + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+}
+
+/**
+ * Significand limbs filled from the most significant bit down. Bits past the
+ * precision are reduced to a round bit and a sticky flag.
+ */
+typedef struct {
+    mp_limb_t *limb;   // Limb being filled
+    int free_bits;     // Bits of it not yet written
+    mpfr_prec_t room;  // Significand bits not yet written
+    int full;          // The round bit has been taken
+    int round_bit;     // First bit past the precision
+    int sticky;        // Any later bit set
+} significand_writer_t;
+
 /**
- * Remove trailing zeros from a number string that has a decimal point
- * Also removes the decimal point if no fractional part remains
+ * Append the low width bits of bits, width < GMP_NUMB_BITS
  */
-static void remove_trailing_zeros(char *str) {
-    // Find decimal point
-    char *decimal = strchr(str, '.');
-    if (decimal == NULL) {
-        return;  // No decimal point, nothing to do
-    }
-    
-    // Find end of string
-    char *end = str + strlen(str) - 1;
-    
-    // Remove trailing zeros
-    while (end > decimal && *end == '0') {
-        *end = '\0';
-        end--;
-    }
-    
-    // Remove decimal point if it's now at the end
-    if (*end == '.') {
-        *end = '\0';
+static void write_bits(significand_writer_t *writer, mp_limb_t bits, int width) {
+    if (writer->full) {
+        writer->sticky |= (bits != 0);
+        return;
+    }
+    if (width > writer->room) {
+        int dropped = width - (int)writer->room;
+        writer->round_bit = (int)((bits >> (dropped - 1)) & 1);
+        writer->sticky |= ((bits & (((mp_limb_t)1 << (dropped - 1)) - 1)) != 0);
+        writer->full = 1;
+        bits >>= dropped;
+        width -= dropped;
+        if (width == 0) {
+            return;
+        }
+    }
+
+    writer->room -= width;
+    if (writer->free_bits >= width) {
+        writer->free_bits -= width;
+        *writer->limb |= bits << writer->free_bits;
+    } else {
+        int spill = width - writer->free_bits;
+        *writer->limb |= bits >> spill;
+        writer->limb--;
+        writer->free_bits = GMP_NUMB_BITS - spill;
+        *writer->limb |= bits << writer->free_bits;
     }
 }
 
 /**
  * Parse a base-32 string to MPFR number
+ *
+ * Every digit is exactly five bits, so plain digit strings are packed into
+ * the significand limbs and rounded to nearest-even in place. Anything else
+ * (exponents, @NaN@, @Inf@, malformed input) goes through mpfr_set_str.
  */
 int parse_base32_to_mpfr(const char *str, mpfr_t result, mpfr_prec_t prec) {
     mpfr_set_prec(result, prec);
-    return mpfr_set_str(result, str, BASE, MPFR_RNDN);
+
+    const char *p = str;
+    int negative = (*p == '-');
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+
+    // Skip leading zeros; digit_exp counts base-32 digits before the point
+    long digit_exp = 0;
+    int after_point = 0;
+    int seen_digit = 0;
+    for (; *p == '0' || *p == '.'; p++) {
+        if (*p == '0') {
+            seen_digit = 1;
+            digit_exp -= after_point;
+        } else if (after_point) {
+            return mpfr_set_str(result, str, BASE, MPFR_RNDN);
+        } else {
+            after_point = 1;
+        }
+    }
+    if (*p == '\0' && seen_digit) {
+        mpfr_set_zero(result, negative ? -1 : 1);
+        return 0;
+    }
+    int value = digit_value(*p);
+    if (value < 0) {
+        return mpfr_set_str(result, str, BASE, MPFR_RNDN);
+    }
+
+    // Make result a regular number so its exponent can be set afterwards
+    mpfr_set_ui(result, 1, MPFR_RNDN);
+    mp_limb_t *limbs = mpfr_custom_get_significand(result);
+    size_t limbs_len = limb_count(prec);
+    memset(limbs, 0, limbs_len * sizeof(mp_limb_t));
+    significand_writer_t writer = {limbs + limbs_len - 1, GMP_NUMB_BITS, prec, 0, 0, 0};
+
+    // The leading digit is non-zero: drop its high zero bits
+    int leading_bits = DIGIT_BITS;
+    while (!(value >> (leading_bits - 1))) {
+        leading_bits--;
+    }
+    digit_exp += !after_point;
+
+    // Collect digits in a word and write them a word at a time
+    mp_limb_t pending = (mp_limb_t)value;
+    int pending_bits = leading_bits;
+    for (p++; ; p++) {
+        value = digit_value(*p);
+        if (value >= 0) {
+            digit_exp += !after_point;
+            pending = (pending << DIGIT_BITS) | (mp_limb_t)value;
+            pending_bits += DIGIT_BITS;
+            if (pending_bits > GMP_NUMB_BITS - 2 * DIGIT_BITS) {
+                write_bits(&writer, pending, pending_bits);
+                pending = 0;
+                pending_bits = 0;
+            }
+        } else if (*p == '.' && !after_point) {
+            after_point = 1;
+        } else if (*p == '\0') {
+            break;
+        } else {
+            return mpfr_set_str(result, str, BASE, MPFR_RNDN);
+        }
+    }
+    write_bits(&writer, pending, pending_bits);
+
+    // value = 0.1xxx * 2^binary_exp
+    mpfr_exp_t binary_exp = (mpfr_exp_t)digit_exp * DIGIT_BITS - (DIGIT_BITS - leading_bits);
+
+    mp_limb_t ulp = (mp_limb_t)1 << (limbs_len * GMP_NUMB_BITS - prec);
+    if (writer.round_bit && (writer.sticky || (limbs[0] & ulp))) {
+        if (mpn_add_1(limbs, limbs, (mp_size_t)limbs_len, ulp)) {
+            limbs[limbs_len - 1] = (mp_limb_t)1 << (GMP_NUMB_BITS - 1);
+            binary_exp++;
+        }
+    }
+
+    if (mpfr_set_exp(result, binary_exp) != 0) {
+        // Outside the exponent range: let MPFR overflow or underflow
+        return mpfr_set_str(result, str, BASE, MPFR_RNDN);
+    }
+    if (negative) {
+        mpfr_neg(result, result, MPFR_RNDN);
+    }
+    return 0;
 }
 
 /**
- * Convert MPFR number to base-32 string
+ * Shape of the decimal notation of a regular number
+ *
+ * mpfr_get_str with n = 0 prints 1 + ceil((prec - 1) / 5) base-32 digits,
+ * which always holds the whole significand, so the digits are exact.
  */
-char* mpfr_to_base32(mpfr_t value) {
-    mpfr_exp_t exp;
-    char *str = mpfr_get_str(NULL, &exp, BASE, 0, value, MPFR_RNDN);
-    
-    if (str == NULL) {
-        return NULL;
+typedef struct {
+    size_t digits;       // Significand digits
+    mpfr_exp_t exp;      // value = 0.d1d2... * 32^exp
+    int shift;           // Zero bits in front of the significand in d1
+} base32_layout_t;
+
+static base32_layout_t base32_layout(mpfr_t value) {
+    base32_layout_t layout;
+    mpfr_exp_t binary_exp = mpfr_get_exp(value);
+    mpfr_prec_t prec = mpfr_get_prec(value);
+
+    layout.digits = 1 + (size_t)((prec + DIGIT_BITS - 2) / DIGIT_BITS);
+    // exp = ceil(binary_exp / 5)
+    layout.exp = binary_exp >= 0
+        ? (binary_exp + DIGIT_BITS - 1) / DIGIT_BITS
+        : -((-binary_exp) / DIGIT_BITS);
+    layout.shift = (int)(layout.exp * DIGIT_BITS - binary_exp);
+    return layout;
+}
+
+/**
+ * Special values that are printed as words
+ */
+static const char *special_string(mpfr_t value) {
+    if (mpfr_nan_p(value)) {
+        return "@NaN@";
     }
-    
-    // Handle special cases
-    if (strcmp(str, "@NaN@") == 0 || strcmp(str, "@Inf@") == 0 || strcmp(str, "-@Inf@") == 0) {
-        char *result = malloc(strlen(str) + 1);
-        if (result) {
-            strcpy(result, str);
-        }
-        mpfr_free_str(str);
-        return result;
+    if (mpfr_inf_p(value)) {
+        return mpfr_signbit(value) ? "-@Inf@" : "@Inf@";
     }
-    
-    // Handle zero
     if (mpfr_zero_p(value)) {
-        mpfr_free_str(str);
-        char *result = malloc(2);
-        if (result) {
-            strcpy(result, "0");
+        return "0";
+    }
+    return NULL;
+}
+
+/**
+ * Write the significand as layout->digits base-32 digits, five bits at a
+ * time straight from the limbs
+ */
+static void write_digits(const mp_limb_t *limbs, size_t limbs_len,
+                         const base32_layout_t *layout, char *dest) {
+    char *end = dest + layout->digits;
+    mp_limb_t carry = 0;             // Bits left over from the previous limb
+    int carry_bits = layout->shift;  // The first digit starts with zero bits
+
+    for (size_t i = limbs_len; i-- > 0 && dest < end; ) {
+        mp_limb_t limb = limbs[i];
+        int available = GMP_NUMB_BITS;
+
+        if (carry_bits > 0) {
+            int needed = DIGIT_BITS - carry_bits;
+            *dest++ = digit_chars[(carry << needed) | (limb >> (GMP_NUMB_BITS - needed))];
+            available -= needed;
         }
-        return result;
-    }
-    
-    // mpfr_get_str returns mantissa and exponent where:
-    // - exp is the number of digits before the radix point
-    // - If exp > 0: integer part has 'exp' digits
-    // - If exp <= 0: number is 0.000...mantissa (with -exp leading zeros after point)
-    
-    size_t len = strlen(str);
-    int sign_offset = (str[0] == '-') ? 1 : 0;
-    size_t mantissa_len = len - sign_offset;
-    
-    // Calculate result size
-    size_t result_size;
-    if (exp > 0) {
-        if ((size_t)exp >= mantissa_len) {
-            // Need trailing zeros: mantissa000
-            result_size = len + (exp - mantissa_len) + 10;
-        } else {
-            // Need decimal point: mantissa -> man.tissa
-            result_size = len + 10;
+        while (available >= DIGIT_BITS && dest < end) {
+            *dest++ = digit_chars[(limb >> (available - DIGIT_BITS)) & (BASE - 1)];
+            available -= DIGIT_BITS;
         }
-    } else {
-        // Need leading zeros: 0.000mantissa
-        result_size = len + (-exp) + 10;
+        carry = limb & (((mp_limb_t)1 << available) - 1);
+        carry_bits = available;
     }
-    
-    char *result = malloc(result_size);
-    if (result == NULL) {
-        mpfr_free_str(str);
-        return NULL;
+
+    // Digits past the last limb
+    if (dest < end && carry_bits > 0) {
+        *dest++ = digit_chars[carry << (DIGIT_BITS - carry_bits)];
     }
-    
-    // Build the result string
-    char *dest = result;
-    char *src = str;
-    
-    // Copy sign if present
-    if (sign_offset) {
-        *dest++ = *src++;
-    }
-    
-    if (exp > 0) {
-        if ((size_t)exp >= mantissa_len) {
-            // Copy all mantissa digits
-            strcpy(dest, src);
-            dest += mantissa_len;
-            // Add trailing zeros
-            for (long i = mantissa_len; i < exp; i++) {
-                *dest++ = '0';
-            }
-            *dest = '\0';
-        } else {
-            // Insert decimal point
-            strncpy(dest, src, exp);
-            dest += exp;
-            *dest++ = '.';
-            strcpy(dest, src + exp);
-        }
-    } else {
+    while (dest < end) {
+        *dest++ = '0';
+    }
+}
+
+size_t mpfr_base32_size(mpfr_t value) {
+    const char *special = special_string(value);
+    if (special != NULL) {
+        return strlen(special) + 1;
+    }
+
+    base32_layout_t layout = base32_layout(value);
+    size_t size = 1 + layout.digits + 2 + 1;  // sign, digits, "0." and null
+    if (layout.exp > 0 && (size_t)layout.exp > layout.digits) {
+        size += (size_t)layout.exp - layout.digits;
+    } else if (layout.exp < 0) {
+        size += (size_t)(-layout.exp);
+    }
+    return size;
+}
+
+int mpfr_to_base32_buffer(mpfr_t value, char *buffer, size_t size) {
+    if (size < mpfr_base32_size(value)) {
+        return -1;
+    }
+
+    const char *special = special_string(value);
+    if (special != NULL) {
+        strcpy(buffer, special);
+        return 0;
+    }
+
+    base32_layout_t layout = base32_layout(value);
+    const mp_limb_t *limbs = mpfr_custom_get_significand(value);
+    size_t limbs_len = limb_count(mpfr_get_prec(value));
+    char *dest = buffer;
+
+    if (mpfr_signbit(value)) {
+        *dest++ = '-';
+    }
+
+    char *point = NULL;
+    if (layout.exp <= 0) {
         // Leading zeros: 0.000...mantissa
         *dest++ = '0';
+        point = dest;
         *dest++ = '.';
-        for (long i = 0; i < -exp; i++) {
+        for (mpfr_exp_t i = 0; i < -layout.exp; i++) {
             *dest++ = '0';
         }
-        strcpy(dest, src);
     }
-    
-    // Remove trailing zeros before returning
-    remove_trailing_zeros(result);
 
-    mpfr_free_str(str);
+    char *digits = dest;
+    write_digits(limbs, limbs_len, &layout, digits);
+    dest += layout.digits;
+
+    if (layout.exp > 0 && (size_t)layout.exp < layout.digits) {
+        // Insert the radix point after the integer digits
+        point = digits + layout.exp;
+        memmove(point + 1, point, layout.digits - (size_t)layout.exp);
+        *point = '.';
+        dest++;
+    }
+
+    if (point == NULL) {
+        // Integer: pad with zeros up to the radix point
+        for (size_t i = layout.digits; i < (size_t)layout.exp; i++) {
+            *dest++ = '0';
+        }
+    } else {
+        // Remove trailing zeros, and the point if no fraction remains
+        while (dest[-1] == '0') {
+            dest--;
+        }
+        if (dest[-1] == '.') {
+            dest--;
+        }
+    }
+    *dest = '\0';
+    return 0;
+}
+
+const char *mpfr_to_base32_reuse(mpfr_t value, base32_buffer_t *buffer) {
+    size_t size = mpfr_base32_size(value);
+    if (size > buffer->size) {
+        char *data = realloc(buffer->data, size);
+        if (data == NULL) {
+            return NULL;
+        }
+        buffer->data = data;
+        buffer->size = size;
+    }
+    mpfr_to_base32_buffer(value, buffer->data, buffer->size);
+    return buffer->data;
+}
+
+/**
+ * Convert MPFR number to base-32 string
+ */
+char* mpfr_to_base32(mpfr_t value) {
+    size_t size = mpfr_base32_size(value);
+    char *result = malloc(size);
+    if (result == NULL) {
+        return NULL;
+    }
+    mpfr_to_base32_buffer(value, result, size);
     return result;
-}
\ No newline at end of file
+}
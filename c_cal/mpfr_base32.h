@@ -5,6 +5,14 @@
 
 #define BASE 32
 
+/**
+ * Heap buffer reused across conversions, grown as needed
+ */
+typedef struct {
+    char *data;
+    size_t size;
+} base32_buffer_t;
+
 /**
  * Parse a base-32 string to MPFR number
  * 
@@ -24,4 +32,33 @@ int parse_base32_to_mpfr(const char *str, mpfr_t result, mpfr_prec_t prec);
  */
 char* mpfr_to_base32(mpfr_t value);
 
+/**
+ * Buffer size needed by mpfr_to_base32_buffer for this value
+ *
+ * @param value The MPFR value to convert
+ * @return Size in bytes, including the terminating null
+ */
+size_t mpfr_base32_size(mpfr_t value);
+
+/**
+ * Convert MPFR number to base-32 string in decimal notation, writing into a
+ * caller-supplied buffer. The output is the same as mpfr_to_base32.
+ *
+ * @param value The MPFR value to convert
+ * @param buffer Destination for the null-terminated string
+ * @param size Size of buffer in bytes
+ * @return 0 on success, non-zero if buffer is smaller than mpfr_base32_size
+ */
+int mpfr_to_base32_buffer(mpfr_t value, char *buffer, size_t size);
+
+/**
+ * Convert MPFR number to base-32 string in a reusable buffer
+ *
+ * @param value The MPFR value to convert
+ * @param buffer Buffer to grow and write into; start from {NULL, 0} and
+ *               release data with free when done
+ * @return buffer->data, or NULL if memory could not be allocated
+ */
+const char *mpfr_to_base32_reuse(mpfr_t value, base32_buffer_t *buffer);
+
 #endif // MPFR_BASE32_H
@@ -0,0 +1,279 @@
+#include "orbit_cache.h"
+#include "mpfr_base32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * 64-bit FNV-1a hash of a string
+ */
+static uint64_t hash_key(const char *key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Join two base-32 conversions as "<prefix><a> <b>"
+ *
+ * @return Newly allocated string, or NULL if memory could not be allocated
+ */
+static char *join_base32(const char *prefix, mpfr_t a, mpfr_t b) {
+    char *a_str = mpfr_to_base32(a);
+    char *b_str = mpfr_to_base32(b);
+    char *text = NULL;
+    if (a_str != NULL && b_str != NULL) {
+        size_t size = strlen(prefix) + strlen(a_str) + strlen(b_str) + 2;
+        text = malloc(size);
+        if (text != NULL) {
+            snprintf(text, size, "%s%s %s", prefix, a_str, b_str);
+        }
+    }
+    free(a_str);
+    free(b_str);
+    return text;
+}
+
+/**
+ * Key text "<precision> <ca> <cb> <escape_radius_squared>" of an orbit
+ *
+ * @return Newly allocated string, or NULL if memory could not be allocated
+ */
+static char *orbit_key(mpfr_t ca, mpfr_t cb, mpfr_t escape_radius_squared) {
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%ld ", (long)mpfr_get_prec(ca));
+    char *c_text = join_base32(prefix, ca, cb);
+    char *radius_str = mpfr_to_base32(escape_radius_squared);
+    char *key = NULL;
+    if (c_text != NULL && radius_str != NULL) {
+        size_t size = strlen(c_text) + strlen(radius_str) + 2;
+        key = malloc(size);
+        if (key != NULL) {
+            snprintf(key, size, "%s %s", c_text, radius_str);
+        }
+    }
+    free(c_text);
+    free(radius_str);
+    return key;
+}
+
+/**
+ * Map the cache file at path read-only and check that it holds this key
+ *
+ * @return 0 on success, non-zero if the file is missing, foreign or corrupt
+ */
+static int map_orbit_file(const char *path, const char *key, mpfr_prec_t precision,
+                          void **mapping, size_t *mapping_size) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(orbit_cache_header_t)) {
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    const orbit_cache_header_t *header = data;
+    size_t key_length = strlen(key);
+    int valid = memcmp(header->magic, ORBIT_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+        header->value_size == sizeof(long double) &&
+        header->mantissa_bits == LDBL_MANT_DIG &&
+        header->precision == precision &&
+        header->length >= 1 &&
+        header->key_length == (int64_t)key_length &&
+        header->resume_length >= 3 &&
+        (size_t)st.st_size == sizeof(orbit_cache_header_t) +
+            2 * header->length * sizeof(long double) + key_length + header->resume_length;
+    if (valid) {
+        const char *stored_key = (const char *)data + sizeof(orbit_cache_header_t) +
+            2 * header->length * sizeof(long double);
+        valid = memcmp(stored_key, key, key_length) == 0;
+    }
+    if (!valid) {
+        munmap(data, st.st_size);
+        return -1;
+    }
+
+    *mapping = data;
+    *mapping_size = st.st_size;
+    return 0;
+}
+
+/**
+ * Write an orbit to a temporary file next to path and rename it into place
+ *
+ * @return 0 on success, non-zero on a write error
+ */
+static int write_orbit_file(const char *path, const reference_orbit_t *orbit, int escaped,
+                            mpfr_prec_t precision, const char *key, const char *resume) {
+    size_t tmp_size = strlen(path) + 32;
+    char *tmp_path = malloc(tmp_size);
+    if (tmp_path == NULL) {
+        return -1;
+    }
+    snprintf(tmp_path, tmp_size, "%s.%ld.tmp", path, (long)getpid());
+
+    orbit_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ORBIT_CACHE_MAGIC, sizeof(header.magic));
+    header.value_size = sizeof(long double);
+    header.mantissa_bits = LDBL_MANT_DIG;
+    header.precision = precision;
+    header.length = orbit->length;
+    header.escaped = escaped;
+    header.key_length = strlen(key);
+    header.resume_length = strlen(resume);
+
+    int failed = 1;
+    FILE *file = fopen(tmp_path, "wb");
+    if (file != NULL) {
+        failed = fwrite(&header, sizeof(header), 1, file) != 1 ||
+            fwrite(orbit->z_real, sizeof(long double), orbit->length, file) != (size_t)orbit->length ||
+            fwrite(orbit->z_imag, sizeof(long double), orbit->length, file) != (size_t)orbit->length ||
+            fwrite(key, 1, header.key_length, file) != (size_t)header.key_length ||
+            fwrite(resume, 1, header.resume_length, file) != (size_t)header.resume_length;
+        if (fclose(file) != 0) {
+            failed = 1;
+        }
+        if (!failed) {
+            failed = rename(tmp_path, path) != 0;
+        }
+        if (failed) {
+            unlink(tmp_path);
+        }
+    }
+    free(tmp_path);
+    return failed ? -1 : 0;
+}
+
+/**
+ * Set orbit to allocated copies of the first length points
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+static int copy_points(reference_orbit_t *orbit, const long double *z_real,
+                       const long double *z_imag, long length) {
+    orbit->z_real = malloc(length * sizeof(long double));
+    orbit->z_imag = malloc(length * sizeof(long double));
+    if (orbit->z_real == NULL || orbit->z_imag == NULL) {
+        free(orbit->z_real);
+        free(orbit->z_imag);
+        orbit->z_real = NULL;
+        orbit->z_imag = NULL;
+        return -1;
+    }
+    memcpy(orbit->z_real, z_real, length * sizeof(long double));
+    memcpy(orbit->z_imag, z_imag, length * sizeof(long double));
+    orbit->length = length;
+    orbit->capacity = length;
+    return 0;
+}
+
+int orbit_cache_reference(const char *dir, reference_orbit_t *orbit, mpfr_t ca, mpfr_t cb,
+                          mpfr_t escape_radius_squared, long max_iterations) {
+    mpfr_prec_t prec = mpfr_get_prec(ca);
+    void *mapping = NULL;
+    size_t mapping_size = 0;
+    int status = 0;
+
+    char *key = orbit_key(ca, cb, escape_radius_squared);
+    if (key == NULL) {
+        return compute_reference_orbit(orbit, ca, cb, escape_radius_squared, max_iterations);
+    }
+    size_t path_size = strlen(dir) + 32;
+    char *path = malloc(path_size);
+    if (path == NULL) {
+        free(key);
+        return compute_reference_orbit(orbit, ca, cb, escape_radius_squared, max_iterations);
+    }
+    snprintf(path, path_size, "%s/%016llx.orbit", dir, (unsigned long long)hash_key(key));
+
+    free_reference_orbit(orbit);
+
+    mpfr_t z_real, z_imag;
+    mpfr_init2(z_real, prec);
+    mpfr_init2(z_imag, prec);
+    mpfr_set_zero(z_real, 1);
+    mpfr_set_zero(z_imag, 1);
+
+    if (map_orbit_file(path, key, prec, &mapping, &mapping_size) == 0) {
+        const orbit_cache_header_t *header = mapping;
+        const long double *cached_real = (const long double *)(header + 1);
+        const long double *cached_imag = cached_real + header->length;
+
+        if (header->escaped || header->length > max_iterations) {
+            // Long enough: use the mapping in place, cut to this request
+            orbit->z_real = (long double *)cached_real;
+            orbit->z_imag = (long double *)cached_imag;
+            orbit->length = header->length <= max_iterations ? header->length : max_iterations + 1;
+            orbit->capacity = 0;
+            orbit->mapping = mapping;
+            orbit->mapping_size = mapping_size;
+            mapping = NULL;
+        } else {
+            // Continue from the stored last point at full precision
+            const char *resume = (const char *)(cached_imag + header->length) + header->key_length;
+            size_t resume_length = header->resume_length;
+            char *resume_text = malloc(resume_length + 1);
+            char *separator = NULL;
+            if (resume_text != NULL) {
+                memcpy(resume_text, resume, resume_length);
+                resume_text[resume_length] = '\0';
+                separator = strchr(resume_text, ' ');
+            }
+            if (separator != NULL) {
+                *separator = '\0';
+            }
+            if (separator == NULL ||
+                parse_base32_to_mpfr(resume_text, z_real, prec) != 0 ||
+                parse_base32_to_mpfr(separator + 1, z_imag, prec) != 0 ||
+                copy_points(orbit, cached_real, cached_imag, header->length) != 0) {
+                // Unreadable resume point: start over
+                mpfr_set_zero(z_real, 1);
+                mpfr_set_zero(z_imag, 1);
+            }
+            free(resume_text);
+        }
+        if (mapping != NULL) {
+            munmap(mapping, mapping_size);
+        }
+    }
+
+    if (orbit->mapping == NULL) {
+        int escaped = 0;
+        if (orbit->length == 0) {
+            // Not cached: start from Z_0 = 0
+            static const long double origin = 0;
+            status = copy_points(orbit, &origin, &origin, 1);
+        }
+        if (status == 0) {
+            status = extend_reference_orbit(orbit, z_real, z_imag, ca, cb,
+                                            escape_radius_squared, max_iterations, &escaped);
+        }
+        char *resume = (status == 0) ? join_base32("", z_real, z_imag) : NULL;
+        if (resume != NULL) {
+            write_orbit_file(path, orbit, escaped, prec, key, resume);
+        }
+        free(resume);
+    }
+
+    mpfr_clear(z_real);
+    mpfr_clear(z_imag);
+    free(path);
+    free(key);
+    return status;
+}
@@ -0,0 +1,58 @@
+#ifndef ORBIT_CACHE_H
+#define ORBIT_CACHE_H
+
+#include <stdint.h>
+#include <mpfr.h>
+#include "perturbation.h"
+
+/*
+ * Persistent reference-orbit cache shared by processes and zoom frames.
+ *
+ * A cache directory holds one file per reference orbit, named after a
+ * 64-bit FNV-1a hash of its key: the precision, the base-32 text of c at that
+ * precision and the escape radius (which decides where an orbit ends). The
+ * iteration count is not part of the name. A file serves every request up to
+ * the length it holds, and a request for more iterations extends it.
+ *
+ *     header   orbit_cache_header_t (64 bytes)
+ *              long double z_real[length]
+ *              long double z_imag[length]
+ *              key text  "<precision> <ca> <cb> <escape_radius_squared>"
+ *              resume text "<za> <zb>", Z_{length-1} at full precision
+ *
+ * Readers map the file read-only and use the arrays in place, so every
+ * process on the machine shares the same pages. Files are never modified:
+ * an extended orbit is written to a temporary file that is renamed over the
+ * old one, and processes that still map the old file keep a valid copy.
+ * Values are stored in the native long double format, so a file written on
+ * another kind of machine is ignored and rewritten.
+ */
+
+#define ORBIT_CACHE_MAGIC "MBREFORB"
+
+typedef struct {
+    char magic[8];
+    uint32_t value_size;        // sizeof(long double) of the writer
+    uint32_t mantissa_bits;     // LDBL_MANT_DIG of the writer
+    int64_t precision;
+    int64_t length;             // Points Z_0 .. Z_{length-1}
+    int64_t escaped;            // 1 if Z_{length-1} escaped, so the orbit is complete
+    int64_t key_length;         // Bytes of key text after the arrays
+    int64_t resume_length;      // Bytes of resume text after the key
+    int64_t reserved;           // Keeps the arrays 16-byte aligned
+} orbit_cache_header_t;
+
+/**
+ * Set orbit to the reference orbit of c = (ca, cb) from Z_0 = 0 that
+ * compute_reference_orbit() would return, taking it from the cache in dir.
+ * A cached orbit that is long enough is mapped read-only and cut to
+ * max_iterations; a shorter one is continued from its stored last point and
+ * written back, and a missing one is computed and written. Failing to write
+ * the cache only costs the reuse: the computed orbit is still returned.
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+int orbit_cache_reference(const char *dir, reference_orbit_t *orbit, mpfr_t ca, mpfr_t cb,
+                          mpfr_t escape_radius_squared, long max_iterations);
+
+#endif // ORBIT_CACHE_H
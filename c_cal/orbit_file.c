@@ -0,0 +1,60 @@
+#include "orbit_file.h"
+#include <string.h>
+
+int orbit_writer_open(orbit_writer_t *writer, const char *path, orbit_format_t format,
+                      long every, mpfr_prec_t precision, long max_iterations) {
+    orbit_header_t header;
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        return -1;
+    }
+    // A full buffer per write keeps the syscalls rare even at one record per step
+    setvbuf(writer->file, NULL, _IOFBF, ORBIT_BUFFER_SIZE);
+    writer->format = format;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ORBIT_MAGIC, sizeof(ORBIT_MAGIC));
+    header.format = (uint32_t)format;
+    header.every = (uint32_t)every;
+    header.precision = precision;
+    header.max_iterations = max_iterations;
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        fclose(writer->file);
+        writer->file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int orbit_writer_write(orbit_writer_t *writer, long iteration, mpfr_t z_real, mpfr_t z_imag) {
+    size_t written;
+
+    if (writer->format == ORBIT_FORMAT_DOUBLE) {
+        orbit_double_record_t record;
+        record.iteration = iteration;
+        record.z_real = mpfr_get_d(z_real, MPFR_RNDN);
+        record.z_imag = mpfr_get_d(z_imag, MPFR_RNDN);
+        written = fwrite(&record, sizeof(record), 1, writer->file);
+    } else {
+        orbit_extended_record_t record;
+        long real_exponent, imag_exponent;
+        record.iteration = iteration;
+        record.real_mantissa = mpfr_get_d_2exp(&real_exponent, z_real, MPFR_RNDN);
+        record.imag_mantissa = mpfr_get_d_2exp(&imag_exponent, z_imag, MPFR_RNDN);
+        record.real_exponent = (int32_t)real_exponent;
+        record.imag_exponent = (int32_t)imag_exponent;
+        written = fwrite(&record, sizeof(record), 1, writer->file);
+    }
+
+    return written == 1 ? 0 : -1;
+}
+
+int orbit_writer_close(orbit_writer_t *writer) {
+    int failed = ferror(writer->file);
+    if (fclose(writer->file) != 0) {
+        failed = 1;
+    }
+    writer->file = NULL;
+    return failed ? -1 : 0;
+}
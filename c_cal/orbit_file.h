@@ -0,0 +1,98 @@
+#ifndef ORBIT_FILE_H
+#define ORBIT_FILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <mpfr.h>
+
+/*
+ * Binary orbit dump written by CAL_ORBIT.
+ *
+ * A 32-byte header is followed by fixed-size records, all in native byte
+ * order (little-endian on x86-64). The number of records is not stored, so
+ * the file can be written to a pipe; a reader takes records until the end.
+ *
+ *     header   char magic[8]        "MBORBIT" and a NUL
+ *              uint32 format        ORBIT_FORMAT_DOUBLE or ORBIT_FORMAT_EXTENDED
+ *              uint32 every         Decimation: every n-th iteration is written
+ *              int64 precision      Bits of the orbit's MPFR computation
+ *              int64 max_iterations Iteration limit of the command
+ *
+ * Each record starts with the iteration number it holds, so a decimated
+ * orbit is self-describing. Record 0 is z0 (iteration 0); the last record is
+ * always the final z, whether or not its iteration is a multiple of every.
+ */
+
+#define ORBIT_MAGIC "MBORBIT"
+
+/** Size of the stdio buffer behind an orbit file */
+#define ORBIT_BUFFER_SIZE (1 << 20)
+
+/**
+ * Record layouts
+ */
+typedef enum {
+    ORBIT_FORMAT_DOUBLE = 1,    // z rounded to two doubles
+    ORBIT_FORMAT_EXTENDED = 2   // mantissa in [0.5, 1) and exponent per part, as mpfr_get_d_2exp
+} orbit_format_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t format;
+    uint32_t every;
+    int64_t precision;
+    int64_t max_iterations;
+} orbit_header_t;
+
+/** Record of ORBIT_FORMAT_DOUBLE, 24 bytes */
+typedef struct {
+    int64_t iteration;
+    double z_real;
+    double z_imag;
+} orbit_double_record_t;
+
+/**
+ * Record of ORBIT_FORMAT_EXTENDED, 32 bytes: part = mantissa * 2^exponent.
+ * The exponent range is that of MPFR, so deep orbits neither underflow nor
+ * overflow; zero has mantissa 0 and exponent 0.
+ */
+typedef struct {
+    int64_t iteration;
+    double real_mantissa;
+    double imag_mantissa;
+    int32_t real_exponent;
+    int32_t imag_exponent;
+} orbit_extended_record_t;
+
+/**
+ * Open orbit file being written
+ */
+typedef struct {
+    FILE *file;
+    orbit_format_t format;
+} orbit_writer_t;
+
+/**
+ * Create (or truncate) the file at path, which may also be a named pipe,
+ * and write the header. Records go through a buffer of ORBIT_BUFFER_SIZE.
+ *
+ * @return 0 on success, non-zero if the file could not be opened or written
+ */
+int orbit_writer_open(orbit_writer_t *writer, const char *path, orbit_format_t format,
+                      long every, mpfr_prec_t precision, long max_iterations);
+
+/**
+ * Write z as the record of this iteration
+ *
+ * @return 0 on success, non-zero on a write error
+ */
+int orbit_writer_write(orbit_writer_t *writer, long iteration, mpfr_t z_real, mpfr_t z_imag);
+
+/**
+ * Flush and close the file
+ *
+ * @return 0 on success, non-zero if buffered records could not be written
+ */
+int orbit_writer_close(orbit_writer_t *writer);
+
+#endif // ORBIT_FILE_H
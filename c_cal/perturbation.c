@@ -0,0 +1,633 @@
+#include "perturbation.h"
+#include "cal_kernel.h"
+#include "orbit_cache.h"
+#include <stdlib.h>
+#include <math.h>
+#include <sys/mman.h>
+
+#define INITIAL_ORBIT_CAPACITY 1024
+
+/**
+ * Append Z_n to a reference orbit, growing the arrays as needed
+ */
+static int orbit_append(reference_orbit_t *orbit, mpfr_t z_real, mpfr_t z_imag) {
+    if (orbit->length == orbit->capacity) {
+        long capacity = orbit->capacity > 0 ? orbit->capacity * 2 : INITIAL_ORBIT_CAPACITY;
+        long double *z_real_new = realloc(orbit->z_real, capacity * sizeof(long double));
+        if (z_real_new == NULL) {
+            return -1;
+        }
+        orbit->z_real = z_real_new;
+        long double *z_imag_new = realloc(orbit->z_imag, capacity * sizeof(long double));
+        if (z_imag_new == NULL) {
+            return -1;
+        }
+        orbit->z_imag = z_imag_new;
+        orbit->capacity = capacity;
+    }
+
+    orbit->z_real[orbit->length] = mpfr_get_ld(z_real, MPFR_RNDN);
+    orbit->z_imag[orbit->length] = mpfr_get_ld(z_imag, MPFR_RNDN);
+    orbit->length++;
+    return 0;
+}
+
+/**
+ * Compute a reference orbit from Z_0 = 0
+ */
+int compute_reference_orbit(reference_orbit_t *orbit, mpfr_t ca, mpfr_t cb,
+                            mpfr_t escape_radius_squared, long max_iterations) {
+    mpfr_t z_real, z_imag;
+    mpfr_prec_t prec = mpfr_get_prec(ca);
+    int escaped;
+    int status;
+
+    if (orbit->mapping != NULL) {
+        free_reference_orbit(orbit);
+    }
+
+    mpfr_init2(z_real, prec);
+    mpfr_init2(z_imag, prec);
+    mpfr_set_zero(z_real, 1);
+    mpfr_set_zero(z_imag, 1);
+
+    orbit->length = 0;
+    status = orbit_append(orbit, z_real, z_imag);
+    if (status == 0) {
+        status = extend_reference_orbit(orbit, z_real, z_imag, ca, cb, escape_radius_squared,
+                                        max_iterations, &escaped);
+    }
+
+    mpfr_clear(z_real);
+    mpfr_clear(z_imag);
+
+    return status;
+}
+
+/**
+ * Continue a reference orbit with the fused MPFR iteration
+ */
+int extend_reference_orbit(reference_orbit_t *orbit, mpfr_t z_real, mpfr_t z_imag,
+                           mpfr_t ca, mpfr_t cb, mpfr_t escape_radius_squared,
+                           long max_iterations, int *escaped) {
+    mpfr_t z_real_sq, z_imag_sq, z_magnitude_squared;
+    mpfr_prec_t prec = mpfr_get_prec(ca);
+    int status = 0;
+
+    mpfr_init2(z_real_sq, prec);
+    mpfr_init2(z_imag_sq, prec);
+    mpfr_init2(z_magnitude_squared, prec);
+
+    mpfr_sqr(z_real_sq, z_real, MPFR_RNDN);
+    mpfr_sqr(z_imag_sq, z_imag, MPFR_RNDN);
+
+    *escaped = 0;
+    for (long i = orbit->length - 1; i < max_iterations && status == 0; i++) {
+        mpfr_mul(z_imag, z_real, z_imag, MPFR_RNDN);
+        mpfr_mul_2ui(z_imag, z_imag, 1, MPFR_RNDN);
+        mpfr_add(z_imag, z_imag, cb, MPFR_RNDN);
+
+        mpfr_sub(z_real, z_real_sq, z_imag_sq, MPFR_RNDN);
+        mpfr_add(z_real, z_real, ca, MPFR_RNDN);
+
+        status = orbit_append(orbit, z_real, z_imag);
+
+        mpfr_sqr(z_real_sq, z_real, MPFR_RNDN);
+        mpfr_sqr(z_imag_sq, z_imag, MPFR_RNDN);
+        mpfr_add(z_magnitude_squared, z_real_sq, z_imag_sq, MPFR_RNDN);
+
+        if (mpfr_cmp(z_magnitude_squared, escape_radius_squared) > 0) {
+            *escaped = 1;
+            break;
+        }
+    }
+
+    mpfr_clear(z_real_sq);
+    mpfr_clear(z_imag_sq);
+    mpfr_clear(z_magnitude_squared);
+
+    return status;
+}
+
+/**
+ * Release the memory held by a reference orbit
+ */
+void free_reference_orbit(reference_orbit_t *orbit) {
+    if (orbit->mapping != NULL) {
+        munmap(orbit->mapping, orbit->mapping_size);
+    } else {
+        free(orbit->z_real);
+        free(orbit->z_imag);
+    }
+    orbit->mapping = NULL;
+    orbit->mapping_size = 0;
+    orbit->z_real = NULL;
+    orbit->z_imag = NULL;
+    orbit->length = 0;
+    orbit->capacity = 0;
+}
+
+/**
+ * Series approximation of dz_n as a polynomial in u = dc / radius,
+ *
+ *     dz_n ~ sum_{k=1..SA_ORDER} a_k u^k,    |u| <= 1
+ *
+ * Scaling by the tile radius keeps the coefficients inside the long double
+ * range at any zoom depth and turns the truncation error bound directly
+ * into a bound on dz.
+ */
+typedef struct {
+    long double radius;
+    long double coeff_real[SA_ORDER];
+    long double coeff_imag[SA_ORDER];
+    long skip;
+    long double error_bound;
+} series_approx_t;
+
+/**
+ * Advance the series along the reference orbit for as long as it stays
+ * accurate. Substituting the series into dz' = 2 Z dz + dz^2 + dc gives
+ *
+ *     a_1' = 2 Z a_1 + radius,    a_k' = 2 Z a_k + sum_{i+j=k} a_i a_j
+ *
+ * and with |u| <= 1 the truncation error e obeys
+ *
+ *     e' <= (2 |Z| + 2 sum |a_k|) e + e^2 + sum_{i+j>SA_ORDER} |a_i| |a_j|
+ *
+ * The skip stops at the last step where e stays below SA_TOLERANCE |a_1|
+ * and no pixel of the disc can have escaped yet.
+ */
+static void compute_series_approximation(const reference_orbit_t *orbit, long double radius,
+                                         long double escape_radius, long max_iterations,
+                                         series_approx_t *series) {
+    long double a_real[SA_ORDER] = { 0 }, a_imag[SA_ORDER] = { 0 };
+    long double next_real[SA_ORDER], next_imag[SA_ORDER];
+    long double error = 0;
+
+    series->radius = radius;
+    series->skip = 0;
+    series->error_bound = 0;
+    for (int k = 0; k < SA_ORDER; k++) {
+        series->coeff_real[k] = 0;
+        series->coeff_imag[k] = 0;
+    }
+
+    // Keep one reference step in hand so the pixel loop can continue
+    for (long n = 0; n + 2 < orbit->length && n < max_iterations; n++) {
+        long double ref_real = orbit->z_real[n];
+        long double ref_imag = orbit->z_imag[n];
+        long double sum_abs = 0, dropped = 0;
+        long double abs_a[SA_ORDER];
+
+        for (int k = 0; k < SA_ORDER; k++) {
+            abs_a[k] = hypotl(a_real[k], a_imag[k]);
+            sum_abs += abs_a[k];
+        }
+        for (int i = 0; i < SA_ORDER; i++) {
+            for (int j = SA_ORDER - 1 - i; j < SA_ORDER; j++) {
+                dropped += abs_a[i] * abs_a[j];
+            }
+        }
+
+        for (int k = 0; k < SA_ORDER; k++) {
+            long double sq_real = 0, sq_imag = 0;
+            // Index k holds the coefficient of u^(k+1)
+            for (int i = 0; i < k; i++) {
+                int j = k - 1 - i;
+                sq_real += a_real[i] * a_real[j] - a_imag[i] * a_imag[j];
+                sq_imag += a_real[i] * a_imag[j] + a_imag[i] * a_real[j];
+            }
+            next_real[k] = 2 * (ref_real * a_real[k] - ref_imag * a_imag[k]) + sq_real;
+            next_imag[k] = 2 * (ref_real * a_imag[k] + ref_imag * a_real[k]) + sq_imag;
+        }
+        next_real[0] += radius;
+
+        error = (2 * hypotl(ref_real, ref_imag) + 2 * sum_abs) * error + error * error + dropped;
+
+        long double next_sum = 0;
+        for (int k = 0; k < SA_ORDER; k++) {
+            next_sum += hypotl(next_real[k], next_imag[k]);
+        }
+        long double next_ref = hypotl(orbit->z_real[n + 1], orbit->z_imag[n + 1]);
+
+        if (error > SA_TOLERANCE * hypotl(next_real[0], next_imag[0]) ||
+            next_ref + next_sum + error > escape_radius) {
+            break;
+        }
+
+        for (int k = 0; k < SA_ORDER; k++) {
+            a_real[k] = next_real[k];
+            a_imag[k] = next_imag[k];
+            series->coeff_real[k] = next_real[k];
+            series->coeff_imag[k] = next_imag[k];
+        }
+        series->skip = n + 1;
+        series->error_bound = error;
+    }
+}
+
+/**
+ * Evaluate the series for one pixel with Horner's scheme
+ */
+static void evaluate_series(const series_approx_t *series, long double dc_real, long double dc_imag,
+                            long double *dz_real, long double *dz_imag) {
+    long double u_real = series->radius > 0 ? dc_real / series->radius : 0;
+    long double u_imag = series->radius > 0 ? dc_imag / series->radius : 0;
+    long double sum_real = 0, sum_imag = 0;
+
+    for (int k = SA_ORDER - 1; k >= 0; k--) {
+        long double t_real = sum_real + series->coeff_real[k];
+        long double t_imag = sum_imag + series->coeff_imag[k];
+        sum_real = t_real * u_real - t_imag * u_imag;
+        sum_imag = t_real * u_imag + t_imag * u_real;
+    }
+
+    *dz_real = sum_real;
+    *dz_imag = sum_imag;
+}
+
+/**
+ * Bilinear approximation of a block of iterations starting at step m:
+ *
+ *     dz_{m+l} ~ A dz_m + B dc,    valid while |dz_m| < radius
+ */
+typedef struct {
+    long double a_real, a_imag;
+    long double b_real, b_imag;
+    long double radius;
+} bla_entry_t;
+
+/**
+ * Binary BLA table: entry k of level j covers iterations k 2^j .. (k+1) 2^j
+ */
+typedef struct {
+    bla_entry_t *levels[BLA_MAX_LEVELS];
+    long level_size[BLA_MAX_LEVELS];
+    int level_count;
+} bla_table_t;
+
+/**
+ * Release the memory held by a BLA table
+ */
+static void free_bla_table(bla_table_t *table) {
+    for (int j = 0; j < table->level_count; j++) {
+        free(table->levels[j]);
+        table->levels[j] = NULL;
+    }
+    table->level_count = 0;
+}
+
+/**
+ * Build the BLA table of a reference orbit for a tile of radius dc_radius.
+ *
+ * A single step has A = 2 Z_m and B = 1; dropping dz^2 is accurate to
+ * BLA_EPSILON while |dz| < BLA_EPSILON |2 Z_m|. Two consecutive blocks x
+ * and y merge into A = A_y A_x, B = A_y B_x + B_y and
+ *
+ *     radius = min(radius_x, (radius_y - |B_x| dc_radius) / |A_x|)
+ *
+ * so that the intermediate delta stays inside the validity disc of y.
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+static int build_bla_table(const reference_orbit_t *orbit, long double dc_radius,
+                           bla_table_t *table) {
+    long steps = orbit->length - 1;
+
+    table->level_count = 0;
+    if (steps < 1) {
+        return 0;
+    }
+
+    for (int j = 0; j < BLA_MAX_LEVELS && (steps >> j) > 0; j++) {
+        long size = steps >> j;
+        bla_entry_t *level = malloc(size * sizeof(bla_entry_t));
+        if (level == NULL) {
+            free_bla_table(table);
+            return -1;
+        }
+        table->levels[j] = level;
+        table->level_size[j] = size;
+        table->level_count = j + 1;
+
+        for (long k = 0; k < size; k++) {
+            bla_entry_t *entry = &level[k];
+            if (j == 0) {
+                entry->a_real = 2 * orbit->z_real[k];
+                entry->a_imag = 2 * orbit->z_imag[k];
+                entry->b_real = 1;
+                entry->b_imag = 0;
+                entry->radius = BLA_EPSILON * hypotl(entry->a_real, entry->a_imag);
+                continue;
+            }
+
+            const bla_entry_t *x = &table->levels[j - 1][2 * k];
+            const bla_entry_t *y = &table->levels[j - 1][2 * k + 1];
+            long double abs_a_x = hypotl(x->a_real, x->a_imag);
+            long double reach = y->radius - hypotl(x->b_real, x->b_imag) * dc_radius;
+
+            entry->a_real = y->a_real * x->a_real - y->a_imag * x->a_imag;
+            entry->a_imag = y->a_real * x->a_imag + y->a_imag * x->a_real;
+            entry->b_real = y->a_real * x->b_real - y->a_imag * x->b_imag + y->b_real;
+            entry->b_imag = y->a_real * x->b_imag + y->a_imag * x->b_real + y->b_imag;
+
+            if (reach <= 0) {
+                entry->radius = 0;
+            } else if (abs_a_x == 0) {
+                entry->radius = x->radius;
+            } else {
+                entry->radius = fminl(x->radius, reach / abs_a_x);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Apply the longest valid BLA block that starts at iteration n and ends by
+ * max_iterations. Single steps are left to the exact perturbation formula.
+ *
+ * @return Number of iterations skipped, 0 if no block applies
+ */
+static long bla_jump(const bla_table_t *table, long n, long max_iterations,
+                     long double *dz_real, long double *dz_imag,
+                     long double dc_real, long double dc_imag) {
+    long double dz_norm_squared = *dz_real * *dz_real + *dz_imag * *dz_imag;
+    int top = table->level_count - 1;
+
+    // Only levels whose block size divides n have an entry starting at n
+    for (int j = 1; j <= top && n != 0; j++) {
+        if ((n >> j) << j != n) {
+            top = j - 1;
+            break;
+        }
+    }
+
+    for (int j = top; j >= 1; j--) {
+        long k = n >> j;
+        long length = 1L << j;
+        if (k >= table->level_size[j] || n + length > max_iterations) {
+            continue;
+        }
+
+        const bla_entry_t *entry = &table->levels[j][k];
+        if (dz_norm_squared < entry->radius * entry->radius) {
+            long double new_real = entry->a_real * *dz_real - entry->a_imag * *dz_imag
+                                 + entry->b_real * dc_real - entry->b_imag * dc_imag;
+            long double new_imag = entry->a_real * *dz_imag + entry->a_imag * *dz_real
+                                 + entry->b_real * dc_imag + entry->b_imag * dc_real;
+            *dz_real = new_real;
+            *dz_imag = new_imag;
+            return length;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Iterate one pixel as a delta against the reference orbit, starting at
+ * iteration start with delta (dz_real, dz_imag).
+ * (dc_real, dc_imag) is the pixel's offset from the orbit's c.
+ * If bla is not NULL, blocks of iterations are skipped where it is valid.
+ */
+static void perturb_pixel(const reference_orbit_t *orbit, const bla_table_t *bla,
+                          perturb_pixel_t *pixel,
+                          long double dc_real, long double dc_imag,
+                          long start, long double dz_real, long double dz_imag,
+                          long double escape_radius_squared, long max_iterations,
+                          perturb_stats_t *stats) {
+    long double z_real = orbit->z_real[start] + dz_real;
+    long double z_imag = orbit->z_imag[start] + dz_imag;
+    long n = start;
+
+    pixel->escaped = 'N';
+    pixel->iterations = start;
+
+    while (n < max_iterations) {
+        if (n + 1 >= orbit->length) {
+            // The reference escaped before this pixel did
+            pixel->escaped = 'G';
+            pixel->glitch_ratio = 1;
+            return;
+        }
+
+        long jump = 0;
+        if (bla != NULL) {
+            jump = bla_jump(bla, n, max_iterations, &dz_real, &dz_imag, dc_real, dc_imag);
+        }
+
+        if (jump > 0) {
+            n += jump;
+            stats->bla_skipped += jump;
+        } else {
+            long double ref_real = orbit->z_real[n];
+            long double ref_imag = orbit->z_imag[n];
+
+            // dz = 2 Z dz + dz^2 + dc
+            long double new_real = 2 * (ref_real * dz_real - ref_imag * dz_imag)
+                                 + (dz_real * dz_real - dz_imag * dz_imag) + dc_real;
+            long double new_imag = 2 * (ref_real * dz_imag + ref_imag * dz_real)
+                                 + 2 * dz_real * dz_imag + dc_imag;
+            dz_real = new_real;
+            dz_imag = new_imag;
+            n++;
+            stats->bla_stepped++;
+        }
+
+        long double ref_real = orbit->z_real[n];
+        long double ref_imag = orbit->z_imag[n];
+        z_real = ref_real + dz_real;
+        z_imag = ref_imag + dz_imag;
+        pixel->iterations = n;
+
+        long double magnitude = z_real * z_real + z_imag * z_imag;
+        if (magnitude > escape_radius_squared) {
+            pixel->escaped = 'Y';
+            break;
+        }
+
+        long double ref_magnitude = ref_real * ref_real + ref_imag * ref_imag;
+        if (magnitude < GLITCH_TOLERANCE * ref_magnitude) {
+            pixel->escaped = 'G';
+            pixel->glitch_ratio = magnitude / ref_magnitude;
+            return;
+        }
+    }
+
+    pixel->z_real = z_real;
+    pixel->z_imag = z_imag;
+}
+
+/**
+ * Finish a glitched pixel with the regular engines at full precision
+ */
+static void finish_pixel_mpfr(perturb_pixel_t *pixel, mpfr_t ref_ca, mpfr_t ref_cb,
+                              mpfr_t escape_radius_squared, long max_iterations) {
+    mpfr_prec_t prec = mpfr_get_prec(ref_ca);
+    mpfr_t ca, cb, z_real, z_imag;
+
+    mpfr_init2(ca, prec);
+    mpfr_init2(cb, prec);
+    mpfr_init2(z_real, prec);
+    mpfr_init2(z_imag, prec);
+
+    mpfr_set_ld(ca, pixel->dc_real, MPFR_RNDN);
+    mpfr_add(ca, ca, ref_ca, MPFR_RNDN);
+    mpfr_set_ld(cb, pixel->dc_imag, MPFR_RNDN);
+    mpfr_add(cb, cb, ref_cb, MPFR_RNDN);
+    mpfr_set_zero(z_real, 1);
+    mpfr_set_zero(z_imag, 1);
+
+    pixel->iterations = iterate_dispatch(z_real, z_imag, ca, cb, escape_radius_squared,
+                                         max_iterations, &pixel->escaped, NULL, NULL, NULL);
+    pixel->z_real = mpfr_get_ld(z_real, MPFR_RNDN);
+    pixel->z_imag = mpfr_get_ld(z_imag, MPFR_RNDN);
+
+    mpfr_clear(ca);
+    mpfr_clear(cb);
+    mpfr_clear(z_real);
+    mpfr_clear(z_imag);
+}
+
+/**
+ * Iterate a tile with automatic re-referencing of glitched pixels
+ */
+int perturb_tile(mpfr_t ref_ca, mpfr_t ref_cb, mpfr_t escape_radius_squared,
+                 long max_iterations, perturb_mode_t mode, const char *orbit_cache,
+                 perturb_pixel_t *pixels, long count, perturb_stats_t *stats) {
+    mpfr_prec_t prec = mpfr_get_prec(ref_ca);
+    reference_orbit_t orbit = { NULL, NULL, 0, 0, NULL, 0 };
+    mpfr_t current_ca, current_cb;
+    long double offset_real = 0, offset_imag = 0;
+    long double escape_ld = mpfr_get_ld(escape_radius_squared, MPFR_RNDN);
+    series_approx_t series = { 0 };
+    bla_table_t bla = { { NULL }, { 0 }, 0 };
+    long pending = count;
+    int status = 0;
+
+    stats->references = 0;
+    stats->rereferenced = 0;
+    stats->fallback = 0;
+    stats->skipped = 0;
+    stats->error_bound = 0;
+    stats->bla_skipped = 0;
+    stats->bla_stepped = 0;
+
+    mpfr_init2(current_ca, prec);
+    mpfr_init2(current_cb, prec);
+    mpfr_set(current_ca, ref_ca, MPFR_RNDN);
+    mpfr_set(current_cb, ref_cb, MPFR_RNDN);
+
+    for (long i = 0; i < count; i++) {
+        pixels[i].escaped = 'G';
+    }
+
+    while (pending > 0 && stats->references < MAX_REFERENCES) {
+        // Later references are picked among this tile's glitches and not shared
+        if (orbit_cache != NULL && stats->references == 0) {
+            status = orbit_cache_reference(orbit_cache, &orbit, current_ca, current_cb,
+                                           escape_radius_squared, max_iterations);
+        } else {
+            status = compute_reference_orbit(&orbit, current_ca, current_cb,
+                                             escape_radius_squared, max_iterations);
+        }
+        if (status != 0) {
+            break;
+        }
+
+        // The series is centered on the first reference only
+        if (mode == PERTURB_SERIES && stats->references == 0) {
+            long double radius = 0;
+            for (long i = 0; i < count; i++) {
+                long double distance = hypotl(pixels[i].dc_real, pixels[i].dc_imag);
+                if (distance > radius) {
+                    radius = distance;
+                }
+            }
+            compute_series_approximation(&orbit, radius, sqrtl(escape_ld), max_iterations, &series);
+            stats->skipped = series.skip;
+            stats->error_bound = series.error_bound;
+        }
+
+        // Every reference gets its own table, sized for the pixels left
+        if (mode == PERTURB_BLA) {
+            long double radius = 0;
+            for (long i = 0; i < count; i++) {
+                if (pixels[i].escaped != 'G') {
+                    continue;
+                }
+                long double distance = hypotl(pixels[i].dc_real - offset_real,
+                                              pixels[i].dc_imag - offset_imag);
+                if (distance > radius) {
+                    radius = distance;
+                }
+            }
+            free_bla_table(&bla);
+            status = build_bla_table(&orbit, radius, &bla);
+            if (status != 0) {
+                break;
+            }
+        }
+
+        perturb_pixel_t *best = NULL;
+        pending = 0;
+
+        for (long i = 0; i < count; i++) {
+            perturb_pixel_t *pixel = &pixels[i];
+            if (pixel->escaped != 'G') {
+                continue;
+            }
+            if (stats->references > 0) {
+                stats->rereferenced++;
+            }
+
+            long double dc_real = pixel->dc_real - offset_real;
+            long double dc_imag = pixel->dc_imag - offset_imag;
+            long double dz_real = 0, dz_imag = 0;
+            long start = 0;
+            if (series.skip > 0 && stats->references == 0) {
+                evaluate_series(&series, dc_real, dc_imag, &dz_real, &dz_imag);
+                start = series.skip;
+            }
+
+            perturb_pixel(&orbit, mode == PERTURB_BLA ? &bla : NULL, pixel,
+                          dc_real, dc_imag, start, dz_real, dz_imag,
+                          escape_ld, max_iterations, stats);
+
+            if (pixel->escaped == 'G') {
+                pending++;
+                if (best == NULL || pixel->glitch_ratio < best->glitch_ratio) {
+                    best = pixel;
+                }
+            }
+        }
+        stats->references++;
+
+        // The deepest glitch is closest to the feature that caused it,
+        // which makes it the best candidate for the next reference
+        if (best != NULL) {
+            offset_real = best->dc_real;
+            offset_imag = best->dc_imag;
+            mpfr_set_ld(current_ca, offset_real, MPFR_RNDN);
+            mpfr_add(current_ca, current_ca, ref_ca, MPFR_RNDN);
+            mpfr_set_ld(current_cb, offset_imag, MPFR_RNDN);
+            mpfr_add(current_cb, current_cb, ref_cb, MPFR_RNDN);
+        }
+    }
+
+    for (long i = 0; i < count && status == 0; i++) {
+        if (pixels[i].escaped == 'G') {
+            finish_pixel_mpfr(&pixels[i], ref_ca, ref_cb, escape_radius_squared, max_iterations);
+            stats->fallback++;
+        }
+    }
+
+    free_reference_orbit(&orbit);
+    free_bla_table(&bla);
+    mpfr_clear(current_ca);
+    mpfr_clear(current_cb);
+
+    return status;
+}
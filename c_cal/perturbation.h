@@ -0,0 +1,135 @@
+#ifndef PERTURBATION_H
+#define PERTURBATION_H
+
+#include <mpfr.h>
+
+/*
+ * Perturbation-theory engine for deep zooms.
+ *
+ * One reference orbit Z_n is computed with MPFR and stored as long doubles.
+ * Every pixel c = C + dc is then iterated as a long double delta
+ *
+ *     dz_{n+1} = 2 Z_n dz_n + dz_n^2 + dc,    z_n = Z_n + dz_n
+ *
+ * which is independent of the working precision. long double keeps the
+ * 15-bit x87 exponent, so deltas far below 1e-308 stay representable.
+ */
+
+/** Pauldelbrot glitch criterion: |Z_n + dz_n|^2 < GLITCH_TOLERANCE * |Z_n|^2 */
+#define GLITCH_TOLERANCE 1e-6L
+
+/** Maximum number of reference orbits per tile before falling back to MPFR */
+#define MAX_REFERENCES 32
+
+/** Number of terms of the series approximation */
+#define SA_ORDER 8
+
+/** Largest truncation error allowed, relative to the linear term of the series */
+#define SA_TOLERANCE 1e-16L
+
+/** Relative size of the dropped dz^2 term for which a BLA step is accepted */
+#define BLA_EPSILON 0x1p-53L
+
+/** Number of levels in a BLA table; level j holds steps of 2^j iterations */
+#define BLA_MAX_LEVELS 48
+
+/**
+ * How pixels are advanced against the reference orbits
+ */
+typedef enum {
+    PERTURB_PLAIN,          // Iterate every pixel from z_0 = 0
+    PERTURB_SERIES,         // Skip ahead with a series approximation
+    PERTURB_BLA             // Jump with bilinear approximations where valid
+} perturb_mode_t;
+
+/**
+ * Reference orbit Z_0 .. Z_{length-1} at reduced (long double) precision.
+ * The arrays are either allocated (capacity > 0) or, for an orbit taken from
+ * the orbit cache, point into a read-only file mapping.
+ */
+typedef struct {
+    long double *z_real;
+    long double *z_imag;
+    long length;
+    long capacity;
+    void *mapping;          // Mapped cache file, NULL if the arrays are allocated
+    size_t mapping_size;
+} reference_orbit_t;
+
+/**
+ * Per-pixel state of a perturbation run
+ */
+typedef struct {
+    long double dc_real;    // Offset of c from the first reference
+    long double dc_imag;
+    long double z_real;     // Final z
+    long double z_imag;
+    long iterations;
+    char escaped;           // 'Y', 'N', or 'G' while glitched
+    long double glitch_ratio;  // |z|^2 / |Z|^2 when the glitch was detected
+} perturb_pixel_t;
+
+/**
+ * Tile-level statistics of a perturbation run
+ */
+typedef struct {
+    long references;        // Reference orbits computed
+    long rereferenced;      // Pixel evaluations repeated after a glitch
+    long fallback;          // Pixels finished with full MPFR
+    long skipped;           // Iterations skipped per pixel by the series approximation
+    long double error_bound;  // Truncation error bound of the series at the skip point
+    long bla_skipped;       // Iterations covered by BLA jumps, summed over pixels
+    long bla_stepped;       // Iterations computed one perturbation step at a time
+} perturb_stats_t;
+
+/**
+ * Compute the reference orbit of c = (ca, cb) from Z_0 = 0 with MPFR at the
+ * precision of ca. Stops after max_iterations steps or once |Z|^2 exceeds
+ * escape_radius_squared (the escaping value is kept). A mapped orbit is
+ * released first.
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+int compute_reference_orbit(reference_orbit_t *orbit, mpfr_t ca, mpfr_t cb,
+                            mpfr_t escape_radius_squared, long max_iterations);
+
+/**
+ * Continue an allocated orbit whose last point Z_{length-1} is (z_real,
+ * z_imag) at full precision, under the same rules as compute_reference_orbit().
+ * (z_real, z_imag) is left at the new last point.
+ *
+ * @param escaped Set to 1 if the last point escaped, 0 otherwise
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+int extend_reference_orbit(reference_orbit_t *orbit, mpfr_t z_real, mpfr_t z_imag,
+                           mpfr_t ca, mpfr_t cb, mpfr_t escape_radius_squared,
+                           long max_iterations, int *escaped);
+
+/**
+ * Release the memory or the file mapping held by a reference orbit
+ */
+void free_reference_orbit(reference_orbit_t *orbit);
+
+/**
+ * Iterate every pixel of a tile from z_0 = 0 against the reference
+ * c = (ref_ca, ref_cb). Glitched pixels, and pixels that outlive an escaping
+ * reference, are re-run against a new reference chosen among them; pixels
+ * still glitched after MAX_REFERENCES orbits are finished with MPFR at the
+ * precision of ref_ca.
+ *
+ * With orbit_cache (a directory, or NULL), the first reference orbit is
+ * taken from the orbit cache (orbit_cache.h) instead of being computed.
+ *
+ * With PERTURB_SERIES, pixels start against the first reference from the
+ * state predicted by a series approximation (see stats->skipped). With
+ * PERTURB_BLA, a table of bilinear approximations is built for every
+ * reference and pixels jump over blocks of iterations wherever their delta
+ * is small enough (see stats->bla_skipped).
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+int perturb_tile(mpfr_t ref_ca, mpfr_t ref_cb, mpfr_t escape_radius_squared,
+                 long max_iterations, perturb_mode_t mode, const char *orbit_cache,
+                 perturb_pixel_t *pixels, long count, perturb_stats_t *stats);
+
+#endif // PERTURBATION_H
@@ -0,0 +1,144 @@
+#include "point_store.h"
+#include "cal_kernel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUCKET_COUNT 1024
+
+/**
+ * djb2 string hash
+ */
+static size_t hash_id(const char *id) {
+    size_t hash = 5381;
+    for (const unsigned char *p = (const unsigned char *)id; *p; p++) {
+        hash = hash * 33 + *p;
+    }
+    return hash;
+}
+
+static void free_point(stored_point_t *point) {
+    mpfr_clear(point->z_real);
+    mpfr_clear(point->z_imag);
+    mpfr_clear(point->ca);
+    mpfr_clear(point->cb);
+    mpfr_clear(point->escape_radius_squared);
+    mpfr_clear(point->dz_real);
+    mpfr_clear(point->dz_imag);
+    free(point->id);
+    free(point);
+}
+
+/**
+ * Double the number of buckets once the table holds one point per bucket
+ *
+ * @return 0 on success, non-zero if memory could not be allocated
+ */
+static int grow_buckets(point_store_t *store) {
+    size_t new_count = store->bucket_count ? store->bucket_count * 2 : INITIAL_BUCKET_COUNT;
+    stored_point_t **new_buckets = calloc(new_count, sizeof(stored_point_t *));
+    if (new_buckets == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < store->bucket_count; i++) {
+        stored_point_t *point = store->buckets[i];
+        while (point != NULL) {
+            stored_point_t *next = point->next;
+            size_t bucket = hash_id(point->id) % new_count;
+            point->next = new_buckets[bucket];
+            new_buckets[bucket] = point;
+            point = next;
+        }
+    }
+
+    free(store->buckets);
+    store->buckets = new_buckets;
+    store->bucket_count = new_count;
+    return 0;
+}
+
+stored_point_t *point_store_add(point_store_t *store, const char *id, mpfr_prec_t precision) {
+    point_store_remove(store, id);
+
+    if (store->count >= store->bucket_count && grow_buckets(store) != 0) {
+        return NULL;
+    }
+
+    stored_point_t *point = malloc(sizeof(stored_point_t));
+    if (point == NULL) {
+        return NULL;
+    }
+    point->id = malloc(strlen(id) + 1);
+    if (point->id == NULL) {
+        free(point);
+        return NULL;
+    }
+    strcpy(point->id, id);
+
+    mpfr_init2(point->z_real, precision);
+    mpfr_init2(point->z_imag, precision);
+    mpfr_init2(point->ca, precision);
+    mpfr_init2(point->cb, precision);
+    mpfr_init2(point->escape_radius_squared, precision);
+    mpfr_init2(point->dz_real, DISTANCE_PRECISION);
+    mpfr_init2(point->dz_imag, DISTANCE_PRECISION);
+    point->detect_period = 0;
+    point->track_distance = 0;
+    point->report_smooth = 0;
+    point->short_z = 0;
+    point->report_z = 0;
+
+    size_t bucket = hash_id(id) % store->bucket_count;
+    point->next = store->buckets[bucket];
+    store->buckets[bucket] = point;
+    store->count++;
+    return point;
+}
+
+stored_point_t *point_store_find(point_store_t *store, const char *id) {
+    if (store->bucket_count == 0) {
+        return NULL;
+    }
+
+    stored_point_t *point = store->buckets[hash_id(id) % store->bucket_count];
+    while (point != NULL && strcmp(point->id, id) != 0) {
+        point = point->next;
+    }
+    return point;
+}
+
+int point_store_remove(point_store_t *store, const char *id) {
+    if (store->bucket_count == 0) {
+        return -1;
+    }
+
+    stored_point_t **link = &store->buckets[hash_id(id) % store->bucket_count];
+    while (*link != NULL && strcmp((*link)->id, id) != 0) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return -1;
+    }
+
+    stored_point_t *point = *link;
+    *link = point->next;
+    free_point(point);
+    store->count--;
+    return 0;
+}
+
+void point_store_clear(point_store_t *store) {
+    for (size_t i = 0; i < store->bucket_count; i++) {
+        stored_point_t *point = store->buckets[i];
+        while (point != NULL) {
+            stored_point_t *next = point->next;
+            free_point(point);
+            point = next;
+        }
+    }
+
+    free(store->buckets);
+    store->buckets = NULL;
+    store->bucket_count = 0;
+    store->count = 0;
+}
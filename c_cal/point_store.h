@@ -0,0 +1,62 @@
+#ifndef POINT_STORE_H
+#define POINT_STORE_H
+
+#include <mpfr.h>
+
+/**
+ * Iteration state of one point kept in memory between commands
+ */
+typedef struct stored_point {
+    char *id;                       // Client-assigned identifier
+    mpfr_t z_real;                  // Current z
+    mpfr_t z_imag;
+    mpfr_t ca;                      // c
+    mpfr_t cb;
+    mpfr_t escape_radius_squared;
+    mpfr_t dz_real;                 // dz/dc at DISTANCE_PRECISION
+    mpfr_t dz_imag;
+    int detect_period;              // Check for cycles when continuing
+    int track_distance;             // Carry dz/dc and report distance estimates
+    int report_smooth;              // Report the normalized iteration count on escape
+    int short_z;                    // Print final z rounded to a double
+    int report_z;                   // Append z to the answers while the point is kept
+    struct stored_point *next;      // Next entry in the same bucket
+} stored_point_t;
+
+/**
+ * Hash table of stored points keyed by id
+ */
+typedef struct {
+    stored_point_t **buckets;
+    size_t bucket_count;
+    size_t count;
+} point_store_t;
+
+/**
+ * Add a point with all values initialized at the given precision (dz/dc at
+ * DISTANCE_PRECISION). An existing point with the same id is replaced.
+ *
+ * @return The new entry, or NULL if memory could not be allocated
+ */
+stored_point_t *point_store_add(point_store_t *store, const char *id, mpfr_prec_t precision);
+
+/**
+ * Look up a point by id
+ *
+ * @return The entry, or NULL if no point has this id
+ */
+stored_point_t *point_store_find(point_store_t *store, const char *id);
+
+/**
+ * Release the point with this id
+ *
+ * @return 0 on success, non-zero if no point has this id
+ */
+int point_store_remove(point_store_t *store, const char *id);
+
+/**
+ * Release every point and the table itself
+ */
+void point_store_clear(point_store_t *store);
+
+#endif // POINT_STORE_H
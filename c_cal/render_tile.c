@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <mpfr.h>
+#include "mpfr_base32.h"
+#include "cal_kernel.h"
+#include "grid.h"
+
+/*
+ * Native tile renderer.
+ *
+ * Takes the same box parameters as py_box_cal/box_calculator.py, generates
+ * the grid, runs the same adaptive-iteration policy and writes the same CSV,
+ * but computes every round on a pool of threads inside one process instead
+ * of piping points to one mandelbrot process per core.
+ *
+ * Each round splits the pending points into chunks that are dealt out to
+ * per-thread deques. A thread works from the back of its own deque and, once
+ * it is empty, steals from the front of the others, so slow chunks (points
+ * near the boundary) do not leave the other cores idle.
+ */
+
+/** Points per work item */
+#define CHUNK_SIZE 16
+
+/** Iteration limit of the adaptive loop, as in box_calculator.py */
+#define MAX_TOTAL_ITERATIONS 10000000L
+
+/**
+ * One grid point and its iteration state
+ */
+typedef struct {
+    long x;
+    long y;
+    char *ca_str;           // c as written to the CSV
+    char *cb_str;
+    mpfr_t ca;
+    mpfr_t cb;
+    mpfr_t z_real;          // z reached so far
+    mpfr_t z_imag;
+    long iterations;        // Cumulative iterations
+    long period;            // Detected cycle length, 0 if none
+    char escaped;           // 'Y' or 'N'
+} tile_point_t;
+
+/**
+ * Double-ended queue of chunk numbers owned by one thread
+ */
+typedef struct {
+    long *chunks;
+    long head;              // Next chunk to steal
+    long tail;              // One past the next chunk to pop
+    pthread_mutex_t lock;
+} work_deque_t;
+
+/**
+ * State shared by the threads of one round
+ */
+typedef struct {
+    tile_point_t *points;
+    long *pending;          // Indices of the points iterated this round
+    long pending_count;
+    long target_iterations; // Cumulative iteration target of the round
+    mpfr_ptr escape_radius_squared;
+    work_deque_t *deques;
+    int thread_count;
+} round_t;
+
+/**
+ * Per-thread arguments and counters
+ */
+typedef struct {
+    round_t *round;
+    int index;
+    long newly_escaped;
+    long interior_points;
+} worker_t;
+
+/**
+ * Count alphanumeric characters in a base-32 string (sign and point excluded)
+ */
+static size_t count_base32_digits(const char *str) {
+    size_t count = 0;
+    for (; *str; str++) {
+        if (isalnum((unsigned char)*str)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Take a chunk from the back of the own deque, or steal one from the front
+ * of another deque
+ *
+ * @return 0 if a chunk was found, non-zero if every deque is empty
+ */
+static int next_chunk(round_t *round, int self, long *chunk) {
+    for (int k = 0; k < round->thread_count; k++) {
+        int victim = (self + k) % round->thread_count;
+        work_deque_t *deque = &round->deques[victim];
+        int found = 0;
+
+        pthread_mutex_lock(&deque->lock);
+        if (deque->head < deque->tail) {
+            *chunk = (k == 0) ? deque->chunks[--deque->tail] : deque->chunks[deque->head++];
+            found = 1;
+        }
+        pthread_mutex_unlock(&deque->lock);
+
+        if (found) {
+            return 0;
+        }
+    }
+    // No work is added during a round, so empty deques mean it is finished
+    return -1;
+}
+
+/**
+ * Iterate one point up to the round's target, with cycle detection and, for
+ * points still at z0 = 0, the cardioid and period-2 disk tests
+ */
+static void iterate_point(round_t *round, tile_point_t *point, worker_t *worker) {
+    if (point->iterations == 0 && mpfr_zero_p(point->z_real) && mpfr_zero_p(point->z_imag)) {
+        point->period = interior_period(point->ca, point->cb);
+        if (point->period != 0) {
+            worker->interior_points++;
+            return;
+        }
+    }
+
+    char escaped;
+    long period;
+    point->iterations += iterate_dispatch(point->z_real, point->z_imag, point->ca, point->cb,
+                                          round->escape_radius_squared,
+                                          round->target_iterations - point->iterations,
+                                          &escaped, &period, NULL, NULL);
+    if (escaped == 'Y') {
+        point->escaped = 'Y';
+        worker->newly_escaped++;
+    } else if (escaped == 'P') {
+        point->period = period;
+    }
+}
+
+static void *worker_thread(void *arg) {
+    worker_t *worker = arg;
+    round_t *round = worker->round;
+    long chunk;
+
+    while (next_chunk(round, worker->index, &chunk) == 0) {
+        long end = (chunk + 1) * CHUNK_SIZE;
+        if (end > round->pending_count) {
+            end = round->pending_count;
+        }
+        for (long i = chunk * CHUNK_SIZE; i < end; i++) {
+            iterate_point(round, &round->points[round->pending[i]], worker);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Iterate the pending points of one round on thread_count threads
+ *
+ * @return 0 on success, non-zero if memory or threads could not be allocated
+ */
+static int run_round(round_t *round, long *newly_escaped, long *interior_points) {
+    int thread_count = round->thread_count;
+    long chunk_count = (round->pending_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    long per_thread = (chunk_count + thread_count - 1) / thread_count;
+    worker_t *workers = calloc(thread_count, sizeof(worker_t));
+    pthread_t *threads = calloc(thread_count, sizeof(pthread_t));
+    long *chunks = malloc((per_thread > 0 ? per_thread * thread_count : 1) * sizeof(long));
+    round->deques = calloc(thread_count, sizeof(work_deque_t));
+
+    if (workers == NULL || threads == NULL || chunks == NULL || round->deques == NULL) {
+        free(workers);
+        free(threads);
+        free(chunks);
+        free(round->deques);
+        return -1;
+    }
+
+    // Deal neighbouring chunks round-robin so expensive regions are spread out
+    for (int t = 0; t < thread_count; t++) {
+        work_deque_t *deque = &round->deques[t];
+        deque->chunks = chunks + (long)t * per_thread;
+        deque->head = 0;
+        deque->tail = 0;
+        pthread_mutex_init(&deque->lock, NULL);
+    }
+    for (long c = 0; c < chunk_count; c++) {
+        work_deque_t *deque = &round->deques[c % thread_count];
+        deque->chunks[deque->tail++] = c;
+    }
+
+    int started = 0;
+    for (int t = 0; t < thread_count; t++) {
+        workers[t].round = round;
+        workers[t].index = t;
+        if (pthread_create(&threads[t], NULL, worker_thread, &workers[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+    // Any threads that failed to start are covered by stealing
+    if (started == 0) {
+        worker_thread(&workers[0]);
+    }
+
+    *newly_escaped = 0;
+    for (int t = 0; t < thread_count; t++) {
+        if (t < started) {
+            pthread_join(threads[t], NULL);
+        }
+        *newly_escaped += workers[t].newly_escaped;
+        *interior_points += workers[t].interior_points;
+        pthread_mutex_destroy(&round->deques[t].lock);
+    }
+
+    free(workers);
+    free(threads);
+    free(chunks);
+    free(round->deques);
+    round->deques = NULL;
+    return 0;
+}
+
+/**
+ * Grid precision as in generate_grid(): 5 bits per base-32 digit plus 64,
+ * rounded up to a multiple of 64
+ */
+static mpfr_prec_t grid_precision(char **bounds) {
+    size_t max_digits = 0;
+    for (int i = 0; i < 4; i++) {
+        size_t digits = count_base32_digits(bounds[i]);
+        if (digits > max_digits) {
+            max_digits = digits;
+        }
+    }
+    mpfr_prec_t precision = ((max_digits * 5 + 64 + 63) / 64) * 64;
+    return precision < 64 ? 64 : precision;
+}
+
+/**
+ * Iteration precision as in calculate_precision(): log2 of the inverse
+ * smallest step plus 32 bits, rounded up to a multiple of 64
+ */
+static mpfr_prec_t iteration_precision(mpfr_t min_ca, mpfr_t max_ca, mpfr_t min_cb, mpfr_t max_cb,
+                                       long resolution_ca, long resolution_cb) {
+    if (resolution_ca <= 1 || resolution_cb <= 1) {
+        return 64;
+    }
+
+    mpfr_t delta_ca, delta_cb;
+    mpfr_init2(delta_ca, mpfr_get_prec(min_ca));
+    mpfr_init2(delta_cb, mpfr_get_prec(min_ca));
+    mpfr_sub(delta_ca, max_ca, min_ca, MPFR_RNDN);
+    mpfr_div_si(delta_ca, delta_ca, resolution_ca, MPFR_RNDN);
+    mpfr_abs(delta_ca, delta_ca, MPFR_RNDN);
+    mpfr_sub(delta_cb, max_cb, min_cb, MPFR_RNDN);
+    mpfr_div_si(delta_cb, delta_cb, resolution_cb, MPFR_RNDN);
+    mpfr_abs(delta_cb, delta_cb, MPFR_RNDN);
+    if (mpfr_less_p(delta_cb, delta_ca)) {
+        mpfr_set(delta_ca, delta_cb, MPFR_RNDN);
+    }
+
+    mpfr_prec_t precision = 64;
+    if (!mpfr_zero_p(delta_ca)) {
+        mpfr_log2(delta_ca, delta_ca, MPFR_RNDN);
+        long required_bits = (long)ceil(-mpfr_get_d(delta_ca, MPFR_RNDN)) + 32;
+        precision = ((required_bits + 63) / 64) * 64;
+        if (precision < 64) {
+            precision = 64;
+        }
+    }
+
+    mpfr_clear(delta_ca);
+    mpfr_clear(delta_cb);
+    return precision;
+}
+
+/**
+ * Free the first n strings of an axis_strings() array and the array itself
+ */
+static void free_axis_strings(char **strings, long n) {
+    if (strings == NULL) {
+        return;
+    }
+    for (long k = 0; k < n; k++) {
+        free(strings[k]);
+    }
+    free(strings);
+}
+
+/**
+ * Format every value of a grid axis in base 32
+ *
+ * @return The strings, or NULL if memory could not be allocated
+ */
+static char **axis_strings(mpfr_t *axis, long n) {
+    char **strings = calloc(n, sizeof(char *));
+    if (strings == NULL) {
+        return NULL;
+    }
+    for (long k = 0; k < n; k++) {
+        strings[k] = mpfr_to_base32(axis[k]);
+        if (strings[k] == NULL) {
+            free_axis_strings(strings, k);
+            return NULL;
+        }
+    }
+    return strings;
+}
+
+/**
+ * Write the grid as CSV in the column layout of box_calculator.py
+ *
+ * @return 0 on success, non-zero on error
+ */
+static int write_csv(const char *output_path, tile_point_t *points, long count) {
+    FILE *file = fopen(output_path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+
+    base32_buffer_t za_text = { NULL, 0 };
+    base32_buffer_t zb_text = { NULL, 0 };
+
+    fprintf(file, "X,Y,CA,CB,ESCAPED,ITERATIONS,FINAL_ZA,FINAL_ZB,PERIOD\r\n");
+    for (long i = 0; i < count; i++) {
+        tile_point_t *point = &points[i];
+        const char *za_str = mpfr_to_base32_reuse(point->z_real, &za_text);
+        const char *zb_str = mpfr_to_base32_reuse(point->z_imag, &zb_text);
+        fprintf(file, "%ld,%ld,%s,%s,%c,%ld,%s,%s,%ld\r\n",
+                point->x, point->y, point->ca_str, point->cb_str, point->escaped,
+                point->iterations, za_str ? za_str : "@NaN@", zb_str ? zb_str : "@NaN@",
+                point->period);
+    }
+
+    free(za_text.data);
+    free(zb_text.data);
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--threads N] <min_ca> <min_cb> <max_ca> <max_cb> <resolution>\n"
+            "       <start_max_iterations> <escape_radius> <output_path>\n",
+            program);
+}
+
+int main(int argc, char *argv[]) {
+    int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int arg = 1;
+
+    if (argc > 2 && strcmp(argv[1], "--threads") == 0) {
+        thread_count = atoi(argv[2]);
+        arg = 3;
+    }
+    if (argc - arg != 8 || thread_count < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    // MPFR keeps its flags and caches in globals unless it was built with thread-local storage
+    if (thread_count > 1 && !mpfr_buildopt_tls_p()) {
+        fprintf(stderr, "MPFR was built without thread-local storage, using 1 thread\n");
+        thread_count = 1;
+    }
+
+    // Bounds in the order of box_calculator.py: min_ca min_cb max_ca max_cb
+    char *bounds[4] = { argv[arg], argv[arg + 2], argv[arg + 1], argv[arg + 3] };
+    long resolution = atol(argv[arg + 4]);
+    long start_max_iterations = atol(argv[arg + 5]);
+    const char *escape_radius_str = argv[arg + 6];
+    const char *output_path = argv[arg + 7];
+
+    if (resolution < 1 || start_max_iterations < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Parse bounds (min_ca, max_ca, min_cb, max_cb) at the grid precision
+    mpfr_prec_t parse_precision = grid_precision(bounds);
+    mpfr_t bound[4], range_ca, range_cb, scratch;
+    int valid = 1;
+    for (int i = 0; i < 4; i++) {
+        mpfr_init2(bound[i], parse_precision);
+        if (parse_base32_to_mpfr(bounds[i], bound[i], parse_precision) != 0 ||
+            !mpfr_number_p(bound[i])) {
+            valid = 0;
+        }
+    }
+    if (!valid) {
+        fprintf(stderr, "Error: invalid base-32 bound\n");
+        return 1;
+    }
+
+    // Imaginary resolution from the aspect ratio, as in generate_grid()
+    mpfr_init2(range_ca, parse_precision);
+    mpfr_init2(range_cb, parse_precision);
+    mpfr_init2(scratch, parse_precision);
+    mpfr_sub(range_ca, bound[1], bound[0], MPFR_RNDN);
+    mpfr_abs(range_ca, range_ca, MPFR_RNDN);
+    mpfr_sub(range_cb, bound[3], bound[2], MPFR_RNDN);
+    mpfr_abs(range_cb, range_cb, MPFR_RNDN);
+
+    long resolution_ca = resolution;
+    long resolution_cb = resolution;
+    if (!mpfr_zero_p(range_ca)) {
+        mpfr_div(scratch, range_cb, range_ca, MPFR_RNDN);
+        resolution_cb = (long)nearbyint(resolution_ca * mpfr_get_d(scratch, MPFR_RNDN));
+        if (resolution_cb < 1) {
+            resolution_cb = 1;
+        }
+    }
+
+    long total_points = resolution_ca * resolution_cb;
+    fprintf(stderr, "Grid size: %ldx%ld = %ld points\n", resolution_ca, resolution_cb, total_points);
+
+    mpfr_prec_t precision = iteration_precision(bound[0], bound[1], bound[2], bound[3],
+                                                resolution_ca, resolution_cb);
+    fprintf(stderr, "Using precision: %ld bits\n", (long)precision);
+
+    mpfr_t escape_radius, escape_radius_squared;
+    mpfr_init2(escape_radius, precision);
+    mpfr_init2(escape_radius_squared, precision);
+    if (parse_base32_to_mpfr(escape_radius_str, escape_radius, precision) != 0 ||
+        !mpfr_number_p(escape_radius) || mpfr_cmp_si(escape_radius, 0) < 0) {
+        fprintf(stderr, "Error: invalid escape radius\n");
+        return 1;
+    }
+    mpfr_sqr(escape_radius_squared, escape_radius, MPFR_RNDN);
+
+    // Generate the grid; c is rounded from the grid precision to the
+    // iteration precision, exactly as parsing its base-32 text would
+    grid_t grid;
+    if (grid_init(&grid, bound[0], bound[1], bound[2], bound[3], resolution_ca, resolution_cb) != 0) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+    char **ca_strs = axis_strings(grid.ca, resolution_ca);
+    char **cb_strs = axis_strings(grid.cb, resolution_cb);
+    tile_point_t *points = calloc(total_points, sizeof(tile_point_t));
+    long *pending = malloc(total_points * sizeof(long));
+    if (ca_strs == NULL || cb_strs == NULL || points == NULL || pending == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        free_axis_strings(ca_strs, resolution_ca);
+        free_axis_strings(cb_strs, resolution_cb);
+        free(points);
+        free(pending);
+        grid_clear(&grid);
+        return 1;
+    }
+
+    for (long i = 0; i < resolution_ca; i++) {
+        for (long j = 0; j < resolution_cb; j++) {
+            tile_point_t *point = &points[i * resolution_cb + j];
+            point->x = i;
+            point->y = j;
+            point->ca_str = ca_strs[i];
+            point->cb_str = cb_strs[j];
+            mpfr_init2(point->ca, precision);
+            mpfr_init2(point->cb, precision);
+            mpfr_init2(point->z_real, precision);
+            mpfr_init2(point->z_imag, precision);
+            grid_point(&grid, i, j, point->ca, point->cb);
+            mpfr_set_zero(point->z_real, 1);
+            mpfr_set_zero(point->z_imag, 1);
+            point->escaped = 'N';
+        }
+    }
+    grid_clear(&grid);
+
+    fprintf(stderr, "Starting %d threads\n", thread_count);
+
+    // Adaptive iteration loop, as in calculate_mandelbrot_grid()
+    round_t round = { points, pending, 0, start_max_iterations, escape_radius_squared,
+                      NULL, thread_count };
+    long interior_points = 0;
+
+    while (1) {
+        round.pending_count = 0;
+        for (long idx = 0; idx < total_points; idx++) {
+            tile_point_t *point = &points[idx];
+            if (point->escaped == 'N' && point->period == 0 &&
+                point->iterations < MAX_TOTAL_ITERATIONS &&
+                point->iterations < round.target_iterations) {
+                pending[round.pending_count++] = idx;
+            }
+        }
+
+        if (round.pending_count == 0) {
+            fprintf(stderr, "All points processed\n");
+            break;
+        }
+
+        fprintf(stderr, "Iteration round: max_iterations=%ld, processing %ld points\n",
+                round.target_iterations, round.pending_count);
+
+        long newly_escaped;
+        if (run_round(&round, &newly_escaped, &interior_points) != 0) {
+            fprintf(stderr, "Error: out of memory\n");
+            return 1;
+        }
+
+        double escape_percentage = 100.0 * newly_escaped / round.pending_count;
+        if (newly_escaped == 0) {
+            fprintf(stderr, "No new escaped points after %ld iterations, stopping\n",
+                    round.target_iterations);
+            break;
+        }
+        if (escape_percentage < 1.0) {
+            fprintf(stderr, "Less than 1%% of points escaped (%.2f%%), stopping\n", escape_percentage);
+            break;
+        }
+        fprintf(stderr, "Points escaped in this round: %ld/%ld (%.2f%%)\n",
+                newly_escaped, round.pending_count, escape_percentage);
+
+        round.target_iterations *= 2;
+        if (round.target_iterations > MAX_TOTAL_ITERATIONS) {
+            fprintf(stderr, "Reached maximum iteration limit\n");
+            break;
+        }
+    }
+
+    fprintf(stderr, "Interior test short-circuited %ld points\n", interior_points);
+    fprintf(stderr, "Writing results to %s\n", output_path);
+    if (write_csv(output_path, points, total_points) != 0) {
+        fprintf(stderr, "Error: cannot write %s\n", output_path);
+        return 1;
+    }
+    fprintf(stderr, "Calculation complete!\n");
+
+    for (long idx = 0; idx < total_points; idx++) {
+        tile_point_t *point = &points[idx];
+        mpfr_clear(point->ca);
+        mpfr_clear(point->cb);
+        mpfr_clear(point->z_real);
+        mpfr_clear(point->z_imag);
+    }
+    free_axis_strings(ca_strs, resolution_ca);
+    free_axis_strings(cb_strs, resolution_cb);
+    free(points);
+    free(pending);
+    for (int i = 0; i < 4; i++) {
+        mpfr_clear(bound[i]);
+    }
+    mpfr_clear(range_ca);
+    mpfr_clear(range_cb);
+    mpfr_clear(scratch);
+    mpfr_clear(escape_radius);
+    mpfr_clear(escape_radius_squared);
+    return 0;
+}
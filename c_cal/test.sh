@@ -67,6 +67,28 @@ run_test_exact() {
     echo ""
 }
 
+# Function to check a value computed by the test itself, such as file contents
+run_check() {
+    local test_name="$1"
+    local expected="$2"
+    local output="$3"
+    
+    TOTAL=$((TOTAL + 1))
+    echo -e "${YELLOW}Test $TOTAL: $test_name${NC}"
+    
+    if [ "$output" = "$expected" ]; then
+        echo -e "${GREEN}✓ PASSED${NC}"
+        echo "  Output: $output"
+        PASSED=$((PASSED + 1))
+    else
+        echo -e "${RED}✗ FAILED${NC}"
+        echo "  Expected: $expected"
+        echo "  Got: $output"
+        FAILED=$((FAILED + 1))
+    fi
+    echo ""
+}
+
 echo "========================================"
 echo "Mandelbrot Calculator Test Suite"
 echo "========================================"
@@ -255,6 +277,310 @@ run_test_exact "Lowercase cal_verbose (should fail)" \
     "BAD_CMD
 EXIT"
 
+# Test 33: Hardware double engine matches MPFR at 53 bits
+run_test_exact "Double engine (53 bits) matches MPFR" \
+    "CAL 53 0 0 0.8a7loa7lo 0.1 100000 2\nEXIT" \
+    "CAL N 0.cikflv9ujlg 0.4lq55ki951c 100000
+EXIT"
+
+# Test 34: Hardware long double engine matches MPFR at 64 bits
+run_test_exact "Long double engine (64 bits) matches MPFR" \
+    "CAL 64 0 0 0.8a7loa7lo 0.1 100000 2\nEXIT" \
+    "CAL N 0.cikflv9ujlfc6 0.4lq55ki951dof 100000
+EXIT"
+
+# Test 35: __float128 engine matches MPFR at 113 bits
+run_test_exact "Float128 engine (113 bits) matches MPFR" \
+    "CAL 113 0 0 0.8a7loa7lo 0.1 100000 2\nEXIT" \
+    "CAL N 0.cikflv9ujlfc64ec3rh6og 0.4lq55ki951dodn0j8iotkau 100000
+EXIT"
+
+# Test 36: Values below the double range hand over to MPFR
+run_test_exact "Double engine underflow falls back to MPFR" \
+    "CAL 53 1@-80 0 1@-100 0 3 2\nEXIT" \
+    "CAL N 0.0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001 0 3
+EXIT"
+
+# Test 37: PERTURB re-references the glitched pixel c = 0 against c = -1
+run_test_exact "PERTURB with glitch re-referencing" \
+    "PERTURB 128 -1 0 100 2 3\n-1 0\n0 0\n3 0\nEXIT" \
+    "CAL N 0 0 100
+CAL N 0 0 100
+CAL Y 3 0 1
+PERTURB 2 1 0
+EXIT"
+
+# Test 38: PERTURB with an invalid pixel consumes all pixel lines
+run_test_exact "PERTURB with invalid pixel" \
+    "PERTURB 128 -1 0 100 2 2\n-1 0\nxyz 0\nCAL 64 0 0 0 0 1 2\nEXIT" \
+    "BAD_CMD
+CAL N 0 0 1
+EXIT"
+
+# Test 39: PERTURB with missing parameters
+run_test_exact "PERTURB with missing parameters" \
+    "PERTURB 128 -1 0 100 2\nEXIT" \
+    "BAD_CMD
+EXIT"
+
+# Test 40: Series approximation skips all but the last reference step
+run_test_exact "PERTURB with series approximation" \
+    "PERTURB 128 0 0 10 2 1 SA\n0 0\nEXIT" \
+    "CAL N 0 0 10
+SA 9 0
+PERTURB 1 0 0
+EXIT"
+
+# Test 41: PERTURB with unknown mode
+run_test_exact "PERTURB with unknown mode" \
+    "PERTURB 128 0 0 10 2 1 XX\n0 0\nEXIT" \
+    "BAD_CMD
+EXIT"
+
+# Test 42: BLA jumps over aligned blocks of 2, 4 and 8 iterations
+run_test_exact "PERTURB with bilinear approximation" \
+    "PERTURB 128 -2 0 16 2 1 BLA\n-2 0\nEXIT" \
+    "CAL N 2 0 16
+BLA 14 2
+PERTURB 1 0 0
+EXIT"
+
+# Test 43: Period-2 cycle found by Brent's algorithm on the hardware path
+run_test_exact "CAL with periodicity detection" \
+    "CAL 64 0 0 -1 0 100 2 PERIOD\nEXIT" \
+    "CAL P -1 0 3 2
+EXIT"
+
+# Test 44: Same cycle in MPFR, escaping and undecided points are unaffected
+run_test_exact "CAL periodicity detection in MPFR" \
+    "CAL 200 0 0 -1 0 100 2 PERIOD\nCAL 64 0 0 1 0 100 2 PERIOD\nCAL 64 0 0 -1.g 0 100 2 PERIOD\nEXIT" \
+    "CAL P -1 0 3 2
+CAL Y 5 0 3
+CAL N -0.7u9ckroboqapo 0 100
+EXIT"
+
+# Test 45: Interior test answers cardioid and period-2 disk points directly
+run_test_exact "CAL with interior test" \
+    "CAL 64 0 0 0 0 100 2 INTERIOR\nCAL 64 0 0 -1 0 100 2 PERIOD INTERIOR\nCAL 64 0 0 0.8 0 100 2 INTERIOR\nCAL 64 0.1 0 0 0 100 2 INTERIOR\nEXIT" \
+    "CAL P 0 0 0 1
+CAL P 0 0 0 2
+CAL N 0.fmc3pu5s7h58 0 100
+CAL N 0 0 100
+EXIT"
+
+# Test 46: STATS counts the points answered by the interior test
+run_test_exact "STATS interior counter" \
+    "STATS\nCAL 64 0 0 -1 0 100 2 INTERIOR\nCAL 64 0 0 -1 0 100 2\nSTATS\nEXIT" \
+    "STATS 0
+CAL P 0 0 0 2
+CAL N 0 0 100
+STATS 1
+EXIT"
+
+# Test 47: CAL_BATCH answers every record in order, tagged with its id
+run_test_exact "CAL_BATCH with flags and an invalid record" \
+    "CAL_BATCH 64 100 2 4 PERIOD INTERIOR\n7 0 0 -1 0\n8 0 0 1 0\nx 0 0 zz! 0\n9 0.1 0 0.8 0\nEXIT" \
+    "RES 7 P 0 0 0 2
+RES 8 Y 5 0 3
+RES x BAD_CMD
+RES 9 N 0.fmc4qraq2qda 0 100
+EXIT"
+
+# Test 48: Invalid CAL_BATCH header still consumes its records
+run_test_exact "CAL_BATCH with invalid header" \
+    "CAL_BATCH 0 100 2 1\n1 0 0 0 0\nCAL_BATCH 64 100 2\nCAL 64 0 0 0 0 5 2\nEXIT" \
+    "BAD_CMD
+BAD_CMD
+CAL N 0 0 5
+EXIT"
+
+# Test 49: KEEP holds undecided points; CONTINUE resumes them by id
+run_test_exact "CAL_BATCH KEEP with CONTINUE" \
+    "CAL_BATCH 64 10 2 3 PERIOD KEEP\na 0 0 -0.k 0.k\nb 0 0 -1 0\nd 0 0 0.8 0\nCONTINUE d 100\nCONTINUE a 100\nEXIT" \
+    "RES a Y -2.8rf5bolpiavf8 -1.161ooi850hlag 9
+RES b P -1 0 3 2
+RES d K 10
+RES d K 100
+RES a BAD_CMD
+EXIT"
+
+# Test 50: DROP returns the z reached so far and releases the point
+run_test_exact "DROP kept point" \
+    "CAL_BATCH 64 10 2 1 KEEP\nd 0 0 0.8 0\nCONTINUE d 100\nDROP d\nDROP d\nCAL 64 0 0 0.8 0 110 2\nEXIT" \
+    "RES d K 10
+RES d K 100
+RES d N 0.fn6p0sqtost9h 0 0
+RES d BAD_CMD
+CAL N 0.fn6p0sqtost9h 0 110
+EXIT"
+
+# Test 51: CAL_GRID computes c from the pixel of the grid set by GRID
+run_test_exact "GRID with CAL_GRID" \
+    "GRID 64 -2 -1 2 1 4 2\nCAL_GRID 64 16 2 5 PERIOD INTERIOR\n0 0 0\n1 0 1\n3 1 1\n7 3 1\nx 4 0\nEXIT" \
+    "GRID OK
+RES 0 Y -2 -1 1
+RES 1 P 2 0 4 1
+RES 3 P 0 0 0 2
+RES 7 Y 5 0 3
+RES x BAD_CMD
+EXIT"
+
+# Test 52: A coordinate computed at the grid precision is rounded like its text
+run_test_exact "CAL_GRID matches CAL_BATCH" \
+    "GRID 128 -2 -1 2 1 3 1\nCAL_GRID 64 20 2 1\na 1 0\nCAL_BATCH 64 20 2 1\na 0 0 -0.lalalalalalalalalalalalalc -1\nEXIT" \
+    "GRID OK
+RES a Y -3.ea7e5cjod4opo -3.j5bqpa0nd4tpg 4
+RES a Y -3.ea7e5cjod4opo -3.j5bqpa0nd4tpg 4
+EXIT"
+
+# Test 53: CAL_GRID without a grid and invalid GRID commands
+run_test_exact "CAL_GRID without grid and invalid GRID" \
+    "CAL_GRID 64 20 2 1\nz 0 0\nGRID 64 -2 -1 2 1 0 1\nGRID 64 -2 -1 zz! 1 2 2\nCAL 64 0 0 0 0 5 2\nEXIT" \
+    "BAD_CMD
+BAD_CMD
+BAD_CMD
+CAL N 0 0 5
+EXIT"
+
+# Test 54: Exterior distance estimate
+run_test_exact "CAL with exterior distance estimate" \
+    "CAL 64 0 0 0.g 0 1000 100000 DISTANCE\nCAL 64 0 0 0.g 0 1 100000 DISTANCE\nEXIT" \
+    "CAL Y 49ehbi.l6968f9 0 9 0.7p407vchgi619
+CAL N 0.g 0 1
+EXIT"
+
+# Test 55: Interior distance estimate from the closed form and from a detected cycle
+run_test_exact "CAL with interior distance estimate" \
+    "CAL 64 0 0 -1 0 100 2 INTERIOR DISTANCE\nCAL 64 0 0 -1 0 100 2 PERIOD DISTANCE\nCAL 64 0 0 0 0 100 2 INTERIOR DISTANCE\nEXIT" \
+    "CAL P 0 0 0 2 0.8
+CAL P -1 0 3 2 0.8
+CAL P 0 0 0 1 0.g
+EXIT"
+
+# Test 56: Kept points carry dz/dc through CONTINUE
+run_test_exact "CAL_BATCH KEEP DISTANCE with CONTINUE" \
+    "CAL 64 0 0 -0.o 0.03 2000 1000 DISTANCE\nCAL_BATCH 64 100 1000 1 KEEP DISTANCE\n7 0 0 -0.o 0.03\nCONTINUE 7 2000\nEXIT" \
+    "CAL Y 1105jo.upi4sou8 -3ffrg.l7f072l8o 1077 0.0002lf2po6mmo8j8o
+RES 7 K 100
+RES 7 Y 1105jo.upi4sou8 -3ffrg.l7f072l8o 977 0.0002lf2po6mmo8j8o
+EXIT"
+
+# Test 57: Smooth iteration count of escaped points and final z rounded to a double
+run_test_exact "CAL with SMOOTH and SHORT_Z" \
+    "CAL 64 0 0 0.g 0 1000 2 SMOOTH\nCAL 256 0 0 0.g 0 1000 100000 SHORT_Z\nCAL 64 0 0 -1 0 1000 2 PERIOD SMOOTH\nEXIT" \
+    "CAL Y 3.4t0g 0 5 5.8002983802768151
+CAL Y 49ehbi.l6968 0 9
+CAL P -1 0 3 2
+EXIT"
+
+# Test 58: Kept points remember SMOOTH and SHORT_Z through CONTINUE and DROP
+run_test_exact "CAL_BATCH KEEP SMOOTH SHORT_Z with CONTINUE and DROP" \
+    "CAL_BATCH 256 5 2 3 KEEP SMOOTH SHORT_Z\na 0 0 0.9 0\nb 0 0 0.g 0\nc 0 0 -0.4 0.4\nCONTINUE a 100\nDROP c\nEXIT" \
+    "RES a K 5
+RES b Y 3.4t0g 0 5 5.8002983802768151
+RES c K 5
+RES a Y 2.nmdbkv73opg 0 11 11.988229188385038
+RES c N -0.3rbmc6gv 0.36sok9b 0
+EXIT"
+
+# Tests 59-61: Binary orbit dumps (CAL_ORBIT)
+ORBIT_DIR=$(mktemp -d)
+trap 'rm -rf "$ORBIT_DIR"' EXIT
+run_test_exact "CAL_ORBIT answers like CAL" \
+    "CAL_ORBIT 64 0 0 -1 0 5 2 $ORBIT_DIR/double.orb\nCAL_ORBIT 64 0 0 0.g 0 100 2 $ORBIT_DIR/extended.orb EVERY 2 EXTENDED\nCAL_ORBIT 64 0 0 0.g 0 100 2 $ORBIT_DIR/bad.orb EVERY 0\nCAL_ORBIT 64 0 0 0.g 0 100 2 $ORBIT_DIR/missing/x.orb\nEXIT" \
+    "CAL_ORBIT N -1 0 5
+CAL_ORBIT Y 3.4t0g 0 5
+BAD_CMD
+BAD_CMD
+EXIT"
+
+# Header, then z0 and every step as (iteration, z_real, z_imag) doubles
+run_check "CAL_ORBIT double records" \
+    "MBORBIT 176 0 -1 0 -1 0 -1" \
+    "$(head -c 7 "$ORBIT_DIR/double.orb") $(wc -c < "$ORBIT_DIR/double.orb" | tr -d ' ') $(od -A n -t f8 -j 40 -w24 -N 144 "$ORBIT_DIR/double.orb" | awk '{printf "%s%g", (NR > 1 ? " " : ""), $1}')"
+
+# Decimated: iterations 0, 2 and 4, then the escape at 5
+run_check "CAL_ORBIT EVERY with EXTENDED records" \
+    "0 2 4 5" \
+    "$(od -A n -t d8 -j 32 -w32 "$ORBIT_DIR/extended.orb" | awk '{printf "%s%s", (NR > 1 ? " " : ""), $1}')"
+
+# Tests 62-63: Reference-orbit cache (ORBIT_CACHE); results match test 37,
+# a shorter request is cut from the cached orbit and a longer one extends it
+run_test_exact "PERTURB with the orbit cache" \
+    "ORBIT_CACHE $ORBIT_DIR/cache\nPERTURB 128 -1 0 100 2 3\n-1 0\n0 0\n3 0\nPERTURB 128 -1 0 50 2 1\n-1 0\nPERTURB 128 -1 0 300 2 1\n-1 0\nORBIT_CACHE $ORBIT_DIR/double.orb\nORBIT_CACHE OFF\nEXIT" \
+    "ORBIT_CACHE OK
+CAL N 0 0 100
+CAL N 0 0 100
+CAL Y 3 0 1
+PERTURB 2 1 0
+CAL N 0 0 50
+PERTURB 1 0 0
+CAL N 0 0 300
+PERTURB 1 0 0
+BAD_CMD
+ORBIT_CACHE OK
+EXIT"
+
+# One file holding Z_0 .. Z_300 at 128 bits, not escaped
+run_check "Orbit cache file extended in place of a new one" \
+    "1 128 301 0" \
+    "$(ls "$ORBIT_DIR/cache" | wc -l | tr -d ' ') $(od -A n -t d8 -j 16 -N 24 "$ORBIT_DIR/cache/"*.orbit | tr -s ' \n' ' ' | sed 's/^ //; s/ $//')"
+
+# Test 64: KEEP_Z reports the z of kept points, and CAL_GRID records may
+# start from it; 10 + 5 iterations reach the z of 15 in one go
+run_test_exact "CAL_GRID from z0 with KEEP_Z" \
+    "GRID 64 -2 -1 2 1 4 2\nCAL_GRID 64 10 2 3 KEEP KEEP_Z\nk 1 1\nm 1 1 0.g 0\ne 2 0 0.o 0\nCONTINUE m 5\nCAL_BATCH 64 15 2 1\nm 0.g 0 -1 0\nCAL_GRID 64 3 2 2\nb 1 1 0.g\nc 1 1 0.g zz!\nEXIT" \
+    "GRID OK
+RES k K 10 0 0
+RES m K 10 -0.0jujedeq0mekg 0
+RES e Y -0.ls -2.4 2
+RES m K 5 -0.vvvvvvvuh5jjk 0
+RES m N -0.vvvvvvvuh5jjk 0 15
+RES b BAD_CMD
+RES c BAD_CMD
+EXIT"
+
+# Test 66: Precisions between the hardware widths are not widened; the
+# results are those of MPFR (CAL_VERBOSE) at 32, 60 and 100 bits
+run_test_exact "CAL below a hardware width matches MPFR" \
+    "CAL 32 0 0 0.8a7loa7lo 0.1 100000 2\nCAL 60 0 0 0.8a7loa7lo 0.1 100000 2\nCAL 100 0 0 0.8a7loa7lo 0.1 100000 2\nEXIT" \
+    "CAL N 0.cikflvg 0.4lq55kk 100000
+CAL N 0.cikflv9ujlfc 0.4lq55ki951dp 100000
+CAL N 0.cikflv9ujlfc64ec3rh6 0.4lq55ki951dodn0j8iot 100000
+EXIT"
+
+# Test 67: A distance of exactly the period tolerance (2^-45 at 53 bits) is
+# not a cycle on the hardware path either; both paths find it one step later
+run_test_exact "Hardware period tolerance bound matches MPFR" \
+    "CAL 53 0 0 1@-9 0 10 2 PERIOD\nCAL_VERBOSE 53 0 0 1@-9 0 10 2 PERIOD\nEXIT" \
+    "CAL P 0.000000001000000001 0 2 1
+CAL_STEP 0.000000001 0 1
+CAL_STEP 0.000000001000000001 0 2
+CAL P 0.000000001000000001 0 2 1
+EXIT"
+
+# Test 68: CONTINUE reports the iterations and smooth count of its own
+# command; added to the 10 iterations before it they give the CAL result
+run_test_exact "CONTINUE counts per command" \
+    "CAL_BATCH 64 10 2 1 KEEP SMOOTH\np 0 0 0.9 0\nCONTINUE p 10\nCAL 64 0 0 0.9 0 200 2 SMOOTH\nEXIT" \
+    "RES p K 10
+RES p Y 2.nmdbkv73opd3 0 6 6.9882291883850378
+CAL Y 2.nmdbkv73opd3 0 16 16.988229188385038
+EXIT"
+
+# Test 69: Records and GRID bounds longer than MAX_LINE_LENGTH are read
+# whole; any other over-long command is refused without breaking the stream
+LONG_ZEROS=$(printf '0%.0s' $(seq 6000))
+run_test_exact "Long records are read whole" \
+    "GRID 64 -2 -2 2 2 4 4\nCAL_GRID 64 10 2 2\na 1 2 0.g 0\nb 1 2 0.g$LONG_ZEROS 0.$LONG_ZEROS\nGRID 64 -2.$LONG_ZEROS -2 2 2 4 4\nCAL 64 0.$LONG_ZEROS 0 0 0 1 2\nSTATS\nEXIT" \
+    "GRID OK
+RES a N -0.0jujedeq0mekg 0 10
+RES b N -0.0jujedeq0mekg 0 10
+GRID OK
+BAD_CMD
+STATS 0
+EXIT"
+
 echo "========================================"
 echo "Test Summary"
 echo "========================================"
@@ -130,6 +130,40 @@ else
     ((FAILED++))
 fi
 
+# Test 37-38: Stream mode
+echo
+echo "Stream mode tests:"
+
+output=$(printf '10TO32 64 -0.5\n32TO10 128 0.8\nBADCMD 64 0\n\n32TO10 64 xyz\n10TO32 64 1e10\n' | $PROGRAM --stream 2>&1)
+expected="-0.g
+0.25
+ERROR: Unknown command 'BADCMD'
+ERROR: Expected <command> <precision> <number>
+ERROR: Invalid base-32 number
+9a0np00"
+if [ "$output" = "$expected" ]; then
+    echo -e "${GREEN}✓${NC} Stream: one result line per input line"
+    ((PASSED++))
+else
+    echo -e "${RED}✗${NC} Stream: one result line per input line"
+    echo "  Expected: $expected"
+    echo "  Got:      $output"
+    ((FAILED++))
+fi
+
+# 3000 base-32 digits print as about 6000 decimal digits
+base32_long="0.$(printf 'a%.0s' {1..3000})"
+base10_long=$(echo "32TO10 15000 $base32_long" | $PROGRAM --stream 2>&1)
+output=$(echo "10TO32 15000 $base10_long" | $PROGRAM --stream 2>&1)
+if [ ${#base10_long} -gt 4096 ] && [ "$output" = "$base32_long" ]; then
+    echo -e "${GREEN}✓${NC} Stream: high-precision round-trip"
+    ((PASSED++))
+else
+    echo -e "${RED}✗${NC} Stream: high-precision round-trip"
+    echo "  Base-10 length: ${#base10_long}"
+    ((FAILED++))
+fi
+
 # Summary
 echo
 echo "================================"
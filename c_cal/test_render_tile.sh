@@ -0,0 +1,77 @@
+#!/bin/bash
+
+# Test script for render_tile executable
+
+PROGRAM="./render_tile"
+OUTPUT_DIR=$(mktemp -d)
+PASSED=0
+FAILED=0
+
+# Colors for output
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+trap 'rm -rf "$OUTPUT_DIR"' EXIT
+
+# Report a test result
+check() {
+    local test_name="$1"
+    local expected="$2"
+    local output="$3"
+
+    if [ "$output" = "$expected" ]; then
+        echo -e "${GREEN}✓${NC} $test_name"
+        ((PASSED++))
+    else
+        echo -e "${RED}✗${NC} $test_name"
+        echo "  Expected: $expected"
+        echo "  Got:      $output"
+        ((FAILED++))
+    fi
+}
+
+# Wrong argument count prints usage and fails
+$PROGRAM -2 -1 2 > /dev/null 2>&1
+check "Usage error" "1" "$?"
+
+# 4x2 grid: escaping, periodic and interior points in CSV layout
+$PROGRAM --threads 2 -2 -1 2 1 4 16 2 "$OUTPUT_DIR/small.csv" 2> /dev/null
+check "Small grid CSV" "X,Y,CA,CB,ESCAPED,ITERATIONS,FINAL_ZA,FINAL_ZB,PERIOD
+0,0,-2,-1,Y,1,-2,-1,0
+0,1,-2,0,N,4,2,0,1
+1,0,-1,-1,Y,3,-1,-3,0
+1,1,-1,0,N,0,0,0,2
+2,0,0,-1,N,5,0,1,2
+2,1,0,0,N,0,0,0,1
+3,0,1,-1,Y,2,1,-3,0
+3,1,1,0,Y,3,5,0,0" "$(tr -d '\r' < "$OUTPUT_DIR/small.csv")"
+
+# Imaginary resolution follows the aspect ratio of the box
+$PROGRAM -2 -1.g 0.g 1.g 40 64 2 "$OUTPUT_DIR/aspect.csv" 2> /dev/null
+check "Aspect ratio" "1920" "$(tail -n +2 "$OUTPUT_DIR/aspect.csv" | wc -l | tr -d ' ')"
+
+# Work stealing must not change the result
+$PROGRAM --threads 1 -0.o4 0.3 -0.o 0.34 60 200 2 "$OUTPUT_DIR/one.csv" 2> /dev/null
+$PROGRAM --threads 8 -0.o4 0.3 -0.o 0.34 60 200 2 "$OUTPUT_DIR/eight.csv" 2> /dev/null
+if cmp -s "$OUTPUT_DIR/one.csv" "$OUTPUT_DIR/eight.csv"; then
+    check "Same result on 1 and 8 threads" "same" "same"
+else
+    check "Same result on 1 and 8 threads" "same" "different"
+fi
+
+# Summary
+echo
+echo "================================"
+echo "Total tests: $((PASSED + FAILED))"
+echo "Passed: $PASSED"
+echo "Failed: $FAILED"
+echo "================================"
+
+if [ $FAILED -eq 0 ]; then
+    echo -e "${GREEN}All tests passed! ✓${NC}"
+    exit 0
+else
+    echo -e "${RED}Some tests failed!${NC}"
+    exit 1
+fi
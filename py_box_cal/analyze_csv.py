@@ -2,25 +2,65 @@
 """
 CSV Analyzer for Mandelbrot Grid Calculator Output
 
-This script analyzes the CSV output from box_calculator.py and provides
-statistics and insights about the calculated Mandelbrot grid.
+This script analyzes the CSV (or binary grid) output from box_calculator.py and
+provides statistics and insights about the calculated Mandelbrot grid.
 """
 
 import sys
 import csv
 from collections import Counter
+from pathlib import Path
+
+# Add py_common to path for imports
+sys.path.insert(0, str(Path(__file__).parent.parent / 'py_common'))
+
+from grid_file import GridFile, is_grid_file  # type: ignore
+
+
+def read_grid_rows(filename):
+    """
+    Read a binary grid file as CSV-like rows. Final z is taken from the
+    full-precision sidecar if there is one, else from the stored floats.
+    """
+    grid = GridFile(filename)
+    escaped = grid.escaped.tolist()
+    iterations = grid.iterations.tolist()
+    final_za = grid.final_za.tolist()
+    final_zb = grid.final_zb.tolist()
+    has_sidecar = grid.has_sidecar()
+    rows = []
+    for x in range(grid.resolution_ca):
+        for y in range(grid.resolution_cb):
+            if has_sidecar:
+                za, zb = grid.final_z_text(x, y)
+            else:
+                za, zb = repr(final_za[x][y]), repr(final_zb[x][y])
+            rows.append({
+                'X': x,
+                'Y': y,
+                'CA': grid.ca_values[x],
+                'CB': grid.cb_values[y],
+                'ESCAPED': 'Y' if escaped[x][y] else 'N',
+                'ITERATIONS': iterations[x][y],
+                'FINAL_ZA': za,
+                'FINAL_ZB': zb
+            })
+    return rows
 
 
 def analyze_csv(filename):
-    """Analyze a Mandelbrot grid CSV file."""
+    """Analyze a Mandelbrot grid CSV or binary grid file."""
     print("=" * 70)
     print(f"Analyzing: {filename}")
     print("=" * 70)
     print()
     # Read CSV
-    with open(filename, 'r') as f:
-        reader = csv.DictReader(f)
-        rows = list(reader)
+    if is_grid_file(filename):
+        rows = read_grid_rows(filename)
+    else:
+        with open(filename, 'r') as f:
+            reader = csv.DictReader(f)
+            rows = list(reader)
     if not rows:
         print("Error: CSV file is empty")
         return
@@ -89,7 +129,7 @@ def analyze_csv(filename):
 
 def main():
     if len(sys.argv) != 2:
-        print("Usage: analyze_csv.py <csv_file>")
+        print("Usage: analyze_csv.py <csv_or_grid_file>")
         sys.exit(1)
     filename = sys.argv[1]
     try:
@@ -15,6 +15,11 @@ from multiprocessing import cpu_count
 from typing import List, Tuple, Dict, Optional
 import threading
 import queue
+import itertools
+import heapq
+import random
+import time
+from array import array
 from pathlib import Path
 
 # Add py_common to path for imports
@@ -23,6 +28,8 @@ sys.path.insert(0, str(Path(__file__).parent.parent / 'py_common'))
 import gmpy2
 
 from mpfr_base32 import parse_mpfr_base32, decimal_to_mpfr_base32  # type: ignore
+from grid_file import GridFile, GridFileWriter, SidecarWriter, is_grid_file  # type: ignore
+from checkpoint_file import Checkpoint, checkpoint_path, read_checkpoint, write_checkpoint  # type: ignore
 
 
 def _count_base32_digits(s: str) -> int:
@@ -86,13 +93,16 @@ def calculate_precision(min_ca: str, max_ca: str, min_cb: str, max_cb: str,
 
 
 def generate_grid(min_ca: str, max_ca: str, min_cb: str, max_cb: str, 
-                 resolution: int) -> Tuple[List[Tuple[str, str, int, int]], int, int]:
+                 resolution: int) -> Tuple[int, List[str], List[str]]:
     """
-    Generate a grid of c = ca + i*cb points.
+    Describe the grid of c = ca + i*cb points without enumerating them.
     Resolution applies to the real part (ca), and imaginary resolution (cb) is calculated
     based on the aspect ratio of the region.
-    Returns tuple of (grid, resolution_ca, resolution_cb) where grid is list of
-    (ca, cb, x, y) tuples in MPFR base-32 format with grid coordinates.
+    Returns tuple of (grid_precision, ca_values, cb_values): the precision at which
+    grid coordinates are computed, and the MPFR base-32 coordinate of every column
+    and row. Point (x, y) is c = ca_values[x] + i*cb_values[y]; the mandelbrot
+    processes compute c themselves from the same GRID descriptor, so only the
+    axes are formatted here.
     """
 
     # Determine precision (bits) from the length of the provided base-32 strings.
@@ -132,40 +142,88 @@ def generate_grid(min_ca: str, max_ca: str, min_cb: str, max_cb: str,
     else:
         resolution_cb = resolution
     
-    grid = []
-    
-    for i in range(resolution_ca):
-        for j in range(resolution_cb):
-            if resolution_ca > 1:
-                # Use gmpy2.mpfr for all arithmetic
-                # max_ca is exclusive, so we divide by resolution_ca (not resolution_ca - 1)
-                i_mpfr = gmpy2.mpfr(i)  # type: ignore
-                res_ca = gmpy2.mpfr(resolution_ca)  # type: ignore
-                ca = min_ca_dec + (max_ca_dec - min_ca_dec) * i_mpfr / res_ca
-            else:
-                ca = min_ca_dec
-            
-            if resolution_cb > 1:
-                j_mpfr = gmpy2.mpfr(j)  # type: ignore
-                res_cb = gmpy2.mpfr(resolution_cb)  # type: ignore
-                cb = min_cb_dec + (max_cb_dec - min_cb_dec) * j_mpfr / res_cb
+    def axis(min_dec, max_dec, count: int) -> List[str]:
+        # Coordinate k of count from its integer offset; max is exclusive,
+        # so we divide by count (not count - 1)
+        values = []
+        for k in range(count):
+            if count > 1:
+                value = min_dec + (max_dec - min_dec) * gmpy2.mpfr(k) / gmpy2.mpfr(count)  # type: ignore
             else:
-                cb = min_cb_dec
-            
-            ca_str = decimal_to_mpfr_base32(ca, precision)
-            cb_str = decimal_to_mpfr_base32(cb, precision)
-            grid.append((ca_str, cb_str, i, j))
+                value = min_dec
+            values.append(decimal_to_mpfr_base32(value, precision))
+        return values
     
-    return grid, resolution_ca, resolution_cb
+    return (precision, axis(min_ca_dec, max_ca_dec, resolution_ca),
+            axis(min_cb_dec, max_cb_dec, resolution_cb))
+
+
+def find_mirror_rows(cb_values: List[str], precision: int) -> 'array[int]':
+    """
+    Find the rows that mirror another row across the real axis. c and its
+    conjugate give conjugate orbits, and MPFR rounds -x to exactly -(rounded x),
+    so a row whose cb is exactly the negation of an earlier row's cb, once both
+    are rounded to the calculation precision like the mandelbrot processes do,
+    has the same results with FINAL_ZB negated.
+
+    Returns, for each row, the earlier row it mirrors, or -1 for rows that must
+    be calculated (no row lines up exactly with their mirror image).
+    """
+    rows = {}
+    for y, value in enumerate(cb_values):
+        rows.setdefault(parse_mpfr_base32(value, precision), y)
+    mirror_rows = array('i', [-1]) * len(cb_values)
+    for y, value in enumerate(cb_values):
+        source = rows.get(-parse_mpfr_base32(value, precision))
+        if source is not None and source < y:
+            mirror_rows[y] = source
+    return mirror_rows
+
+
+def negate_base32(value: str) -> str:
+    """Negate an MPFR base-32 string."""
+    if value.startswith('-'):
+        return value[1:]
+    return value if value == '0' else '-' + value
+
+
+def mirror_source(band: 'BandResults', resolution_cb: int,
+                  mirror_rows: Optional['array[int]'], i: int) -> int:
+    """The band index whose results point i of the band copies (i itself if none)."""
+    if mirror_rows is None:
+        return i
+    y = (band.first + i) % resolution_cb
+    return i if mirror_rows[y] < 0 else i - y + mirror_rows[y]
+
+
+def copy_mirrored(band: 'BandResults', i: int, source: int):
+    """Give point i of the band the results of its source point, mirrored."""
+    band.escaped[i] = band.escaped[source]
+    band.iterations[i] = band.iterations[source]
+    band.period[i] = band.period[source]
+    band.smooth[i] = band.smooth[source]
+    band.final_za[i] = band.final_za[source]
+    band.final_zb[i] = negate_base32(band.final_zb[source])
 
 
 class MandelbrotWorker:
     """
     Manages a single mandelbrot process for parallel computation.
+    With smooth, batch results of escaped points carry the normalized
+    iteration count; with short_z, final z comes back rounded to 53 bits;
+    with keep_z, kept points come back with the z they reached.
     """
     
-    def __init__(self, mandelbrot_path: str):
+    # Input that always fits in an empty pipe (one page, the smallest pipe
+    # capacity Linux gives), so it can be written before any result is read
+    PIPE_SAFE_BYTES = 4096
+    
+    def __init__(self, mandelbrot_path: str, smooth: bool = False, short_z: bool = False,
+                 keep_z: bool = False):
         self.mandelbrot_path = mandelbrot_path
+        self.smooth = smooth
+        self.keep_z = keep_z
+        self.result_flags = (" SMOOTH" if smooth else "") + (" SHORT_Z" if short_z else "")
         self.process: Optional[subprocess.Popen[str]] = None
         self.lock = threading.Lock()
         self._start_process()
@@ -181,34 +239,159 @@ class MandelbrotWorker:
             bufsize=1
         )
     
-    def calculate(self, precision: int, za: str, zb: str, ca: str, cb: str,
-                 max_iterations: int, escape_radius: str) -> Dict:
+    def _read_results(self, count: int) -> List[Dict]:
         """
-        Send CAL command and receive result.
-        Returns dict with keys: escaped, final_za, final_zb, iterations
+        Read and parse count result lines of CAL_GRID, CONTINUE or DROP:
+        RES <idx> <escaped> <final_za> <final_zb> <iterations> (followed by
+        <smooth> for an escaped point if the worker was created with smooth),
+        RES <idx> P <final_za> <final_zb> <iterations> <period> for a periodic orbit, or
+        RES <idx> K <iterations> for a point kept in the process (followed by
+        <za> <zb> if the worker was created with keep_z).
+        Returns list of dicts with keys: idx, escaped, final_za, final_zb,
+        iterations, period, and smooth for escaped points of a smooth worker
+        (for kept points, final_za and final_zb are the z reached, and only
+        present with keep_z)
+        """
+        assert self.process and self.process.stdout
+        results = []
+        for _ in range(count):
+            response = self.process.stdout.readline().strip()
+            parts = response.split()
+            if len(parts) == 4 + 2 * self.keep_z and parts[0] == 'RES' and parts[2] == 'K':
+                result = {
+                    'idx': int(parts[1]),
+                    'escaped': 'K',
+                    'iterations': int(parts[3]),
+                    'period': 0
+                }
+                if self.keep_z:
+                    result['final_za'] = parts[4]
+                    result['final_zb'] = parts[5]
+                results.append(result)
+                continue
+            with_smooth = self.smooth and len(parts) > 2 and parts[2] == 'Y'
+            if len(parts) == 7 and parts[0] == 'RES' and parts[2] == 'P':
+                period = int(parts[6])
+            elif len(parts) == 6 + with_smooth and parts[0] == 'RES':
+                period = 0
+            else:
+                raise ValueError(f"Invalid response: {response}")
+            
+            result = {
+                'idx': int(parts[1]),
+                'escaped': parts[2],
+                'final_za': parts[3],
+                'final_zb': parts[4],
+                'iterations': int(parts[5]),
+                'period': period
+            }
+            if with_smooth:
+                result['smooth'] = float(parts[6])
+            results.append(result)
+        return results
+    
+    def _send_lines(self, lines: List[str]):
+        """Write several command lines in a single call."""
+        assert self.process and self.process.stdin
+        self.process.stdin.write("\n".join(lines) + "\n")
+        self.process.stdin.flush()
+    
+    def _exchange(self, lines: List[str], count: int) -> List[Dict]:
+        """
+        Send command lines and read their count result lines. Longer input is
+        written from a separate thread while the results are read: the
+        process answers records as it reads them, so with long z in both
+        directions each side could otherwise fill its pipe and wait for the
+        other forever.
+        """
+        text = "\n".join(lines) + "\n"
+        if len(text) <= self.PIPE_SAFE_BYTES:
+            self._send_lines(lines)
+            return self._read_results(count)
+        
+        assert self.process and self.process.stdin
+        stdin = self.process.stdin
+        write_errors = []
+        
+        def write():
+            try:
+                stdin.write(text)
+                stdin.flush()
+            except OSError as e:
+                write_errors.append(e)
+        
+        writer = threading.Thread(target=write, daemon=True)
+        writer.start()
+        results = self._read_results(count)
+        writer.join()
+        if write_errors:
+            raise write_errors[0]
+        return results
+    
+    def _run_batch(self, command: str, precision: int, max_iterations: int,
+                   escape_radius: str, record_lines: List[str], keep: bool) -> List[Dict]:
+        """Send one CAL_GRID command and receive its results in order."""
+        with self.lock:
+            flags = "PERIOD INTERIOR" + (" KEEP" if keep else "") + \
+                (" KEEP_Z" if keep and self.keep_z else "") + self.result_flags
+            lines = [f"{command} {precision} {max_iterations} {escape_radius} {len(record_lines)} {flags}"]
+            lines.extend(record_lines)
+            return self._exchange(lines, len(record_lines))
+    
+    def set_grid(self, grid_precision: int, min_ca: str, min_cb: str, max_ca: str, max_cb: str,
+                 resolution_ca: int, resolution_cb: int):
+        """Send the GRID descriptor used by calculate_grid_batch()."""
+        with self.lock:
+            self._send_lines([f"GRID {grid_precision} {min_ca} {min_cb} {max_ca} {max_cb} "
+                              f"{resolution_ca} {resolution_cb}"])
+            assert self.process and self.process.stdout
+            response = self.process.stdout.readline().strip()
+            if response != 'GRID OK':
+                raise ValueError(f"Invalid response: {response}")
+    
+    def calculate_grid_batch(self, precision: int, max_iterations: int, escape_radius: str,
+                             records: List[Tuple], keep: bool = False) -> List[Dict]:
+        """
+        Send one CAL_GRID command for records of (idx, x, y), each starting at
+        z0 = 0, or (idx, x, y, za, zb) starting at z0 = za + zb i; c is
+        computed by the process from the grid set by set_grid(). With keep,
+        undecided points stay in the process (escaped 'K') and are resumed
+        with continue_batch().
+        """
+        return self._run_batch("CAL_GRID", precision, max_iterations, escape_radius,
+                               [" ".join(str(field) for field in record) for record in records],
+                               keep)
+    
+    def continue_batch(self, records: List[Tuple[int, int]]) -> List[Dict]:
+        """
+        Resume kept points with one CONTINUE command per (idx, more_iterations)
+        record, all sent in one go.
+        """
+        with self.lock:
+            return self._exchange([f"CONTINUE {idx} {more}" for idx, more in records],
+                                  len(records))
+    
+    def drop_batch(self, indices: List[int]) -> List[Dict]:
+        """Release kept points and receive the z each one had reached."""
+        with self.lock:
+            return self._exchange([f"DROP {idx}" for idx in indices], len(indices))
+    
+    def stats(self) -> int:
+        """
+        Send STATS command and return the number of points the process
+        answered with the interior test.
         """
         with self.lock:
-            # Send CAL command
-            cmd = f"CAL {precision} {za} {zb} {ca} {cb} {max_iterations} {escape_radius}\n"
-            assert self.process and self.process.stdin
-            self.process.stdin.write(cmd)
+            assert self.process and self.process.stdin and self.process.stdout
+            self.process.stdin.write("STATS\n")
             self.process.stdin.flush()
             
-            # Read response
-            assert self.process.stdout
+            # Parse response: STATS <interior_points>
             response = self.process.stdout.readline().strip()
-            
-            # Parse response: CAL <escaped> <final_za> <final_zb> <iterations>
             parts = response.split()
-            if len(parts) != 5 or parts[0] != 'CAL':
+            if len(parts) != 2 or parts[0] != 'STATS':
                 raise ValueError(f"Invalid response: {response}")
-            
-            return {
-                'escaped': parts[1],
-                'final_za': parts[2],
-                'final_zb': parts[3],
-                'iterations': int(parts[4])
-            }
+            return int(parts[1])
     
     def close(self):
         """Close the mandelbrot process."""
@@ -217,74 +400,245 @@ class MandelbrotWorker:
                 self.process.stdin.write("EXIT\n")
                 self.process.stdin.flush()
                 self.process.wait()
+    
+    def kill(self):
+        """Kill the mandelbrot process without waiting for the command it is on."""
+        if self.process:
+            self.process.kill()
+            self.process.wait()
+
+
+class WorkerError(Exception):
+    """A task failed in a worker thread; raised where the pool's results are taken."""
 
 
 class MandelbrotPool:
     """
     Pool of mandelbrot worker processes for parallel computation.
+    New points are sent to the workers in CAL_GRID batches through a shared
+    queue. Undecided points stay in the process that computed them, so their
+    continuations go through that worker's own queue.
+    
+    Both kinds of queue are ordered by the estimated cost of a task, most
+    expensive first (tasks of equal cost in submission order), so long tasks
+    do not start last and leave a tail. The time each worker spends on tasks
+    is recorded for load_report().
+    
+    smooth, short_z and keep_z are passed on to every MandelbrotWorker.
+    
+    If a task fails, its worker takes no further tasks and the error is
+    raised as a WorkerError by get_results() or next_results(); the caller
+    then stops the pool with terminate().
     """
     
-    def __init__(self, mandelbrot_path: str, num_workers: Optional[int] = None):
+    # Largest number of points sent in one CAL_GRID command
+    MAX_BATCH_SIZE = 256
+    # Largest number of cheap points grouped into one task by the caller
+    MAX_CHEAP_BATCH_SIZE = 1024
+    
+    def __init__(self, mandelbrot_path: str, num_workers: Optional[int] = None,
+                 smooth: bool = False, short_z: bool = False, keep_z: bool = False):
         if num_workers is None:
             num_workers = cpu_count()
         
-        self.workers = [MandelbrotWorker(mandelbrot_path) for _ in range(num_workers)]
-        self.task_queue = queue.Queue()
+        self.workers = [MandelbrotWorker(mandelbrot_path, smooth, short_z, keep_z)
+                        for _ in range(num_workers)]
+        self.task_queue = queue.PriorityQueue()
+        self.worker_queues = [queue.PriorityQueue() for _ in self.workers]
         self.result_queue = queue.Queue()
         self.worker_threads = []
         self.running = True
+        self._order = itertools.count()
+        
+        # Per worker, only written by its own thread
+        self.busy_time = [0.0] * num_workers
+        self.task_counts = [0] * num_workers
+        self.point_counts = [0] * num_workers
+        self.iteration_counts = [0] * num_workers
+    
+    def _put(self, target_queue: queue.PriorityQueue, cost: float, task):
+        """Queue a task; higher cost is taken first."""
+        target_queue.put((-cost, next(self._order), task))
     
-    def _worker_thread(self, worker: MandelbrotWorker):
-        """Worker thread that processes tasks from the queue."""
+    def _next_task(self, worker_index: int):
+        """
+        Take the next task for a worker, preferring its own queue.
+        Returns (task, source queue) or raises queue.Empty.
+        """
+        own_queue = self.worker_queues[worker_index]
+        try:
+            return own_queue.get_nowait()[2], own_queue
+        except queue.Empty:
+            return self.task_queue.get(timeout=0.01)[2], self.task_queue
+    
+    def _worker_thread(self, worker_index: int):
+        """Worker thread that processes tasks from the queues."""
+        worker = self.workers[worker_index]
+        failed = False
         while self.running:
             try:
-                task = self.task_queue.get(timeout=0.1)
-                if task is None:
-                    break
-                
-                idx, precision, za, zb, ca, cb, max_iterations, escape_radius = task
-                result = worker.calculate(precision, za, zb, ca, cb, max_iterations, escape_radius)
-                result['idx'] = idx
-                result['ca'] = ca
-                result['cb'] = cb
-                self.result_queue.put(result)
-                self.task_queue.task_done()
+                task, source = self._next_task(worker_index)
             except queue.Empty:
                 continue
+            if task is None:
+                source.task_done()
+                break
+            if failed:
+                # The process may be out of step with its commands
+                source.task_done()
+                continue
+            
+            started = time.perf_counter()
+            try:
+                kind = task[0]
+                if kind == 'GRID_BATCH':
+                    _, precision, max_iterations, escape_radius, records, keep = task
+                    results = worker.calculate_grid_batch(precision, max_iterations, escape_radius,
+                                                          records, keep)
+                elif kind == 'CONTINUE':
+                    results = worker.continue_batch(task[1])
+                else:
+                    results = worker.drop_batch(task[1])
+                for result in results:
+                    result['worker'] = worker_index
+                    self.iteration_counts[worker_index] += result['iterations']
+                self.task_counts[worker_index] += 1
+                self.point_counts[worker_index] += len(results)
+                # All results of a task arrive together, so continuations can be
+                # batched again
+                self.result_queue.put(results)
             except Exception as e:
-                print(f"Worker error: {e}", file=sys.stderr)
-                self.task_queue.task_done()
+                failed = True
+                self.result_queue.put(WorkerError(f"worker {worker_index} failed: {e}"))
+            self.busy_time[worker_index] += time.perf_counter() - started
+            source.task_done()
     
     def start(self):
         """Start worker threads."""
-        for worker in self.workers:
-            thread = threading.Thread(target=self._worker_thread, args=(worker,))
+        for worker_index in range(len(self.workers)):
+            thread = threading.Thread(target=self._worker_thread, args=(worker_index,))
             thread.start()
             self.worker_threads.append(thread)
     
-    def submit(self, idx: int, precision: int, za: str, zb: str, ca: str, cb: str,
-              max_iterations: int, escape_radius: str):
-        """Submit a calculation task."""
-        self.task_queue.put((idx, precision, za, zb, ca, cb, max_iterations, escape_radius))
+    def _batch_size(self, count: int) -> int:
+        """Batches small enough to keep every worker busy."""
+        per_worker = math.ceil(count / (4 * len(self.workers)))
+        return max(1, min(self.MAX_BATCH_SIZE, per_worker))
+    
+    def set_grid(self, grid_precision: int, min_ca: str, min_cb: str, max_ca: str, max_cb: str,
+                 resolution_ca: int, resolution_cb: int):
+        """Send the GRID descriptor to every worker process."""
+        for worker in self.workers:
+            worker.set_grid(grid_precision, min_ca, min_cb, max_ca, max_cb,
+                            resolution_ca, resolution_cb)
+    
+    def submit_grid_batch(self, precision: int, max_iterations: int, escape_radius: str,
+                          records: List[Tuple], keep: bool = False):
+        """
+        Submit grid points of (idx, x, y) or (idx, x, y, za, zb) sharing the
+        same parameters to any worker. With keep, undecided points stay in the
+        worker's process; their results carry the worker index for
+        submit_continue(). The grid must have been sent with set_grid().
+        """
+        self._submit_batches('GRID_BATCH', precision, max_iterations, escape_radius, records, keep)
+    
+    def submit_grid_task(self, precision: int, max_iterations: int, escape_radius: str,
+                         records: List[Tuple[int, int, int]], keep: bool, cost: float):
+        """
+        Submit grid points of (idx, x, y) as a single task with the given
+        estimated cost, for callers that form their own batches.
+        """
+        self._put(self.task_queue, cost,
+                  ('GRID_BATCH', precision, max_iterations, escape_radius, records, keep))
+    
+    def queued_tasks(self) -> int:
+        """Number of tasks waiting on the shared queue."""
+        return self.task_queue.qsize()
+    
+    def _submit_batches(self, kind: str, precision: int, max_iterations: int,
+                        escape_radius: str, records: List, keep: bool):
+        """Split records into batches on the shared queue."""
+        batch_size = self._batch_size(len(records))
+        for start in range(0, len(records), batch_size):
+            batch = records[start:start + batch_size]
+            self._put(self.task_queue, max_iterations * len(batch),
+                      (kind, precision, max_iterations, escape_radius, batch, keep))
+    
+    def submit_continue(self, worker_index: int, records: List[Tuple[int, int]]):
+        """
+        Resume (idx, more_iterations) points kept by the given worker. A point
+        that ran its whole previous budget is expected to use the new one, so
+        a batch costs the sum of its budgets.
+        """
+        for start in range(0, len(records), self.MAX_BATCH_SIZE):
+            batch = records[start:start + self.MAX_BATCH_SIZE]
+            self._put(self.worker_queues[worker_index], sum(more for _, more in batch),
+                      ('CONTINUE', batch))
+    
+    def submit_drop(self, worker_index: int, indices: List[int]):
+        """Release points kept by the given worker, collecting their final z."""
+        for start in range(0, len(indices), self.MAX_BATCH_SIZE):
+            self._put(self.worker_queues[worker_index], 0,
+                      ('DROP', indices[start:start + self.MAX_BATCH_SIZE]))
     
     def get_results(self, count: int) -> List[Dict]:
-        """Get results from the result queue."""
+        """Get count results from the result queue."""
         results = []
-        for _ in range(count):
-            results.append(self.result_queue.get())
+        while len(results) < count:
+            results.extend(self._task_results(self.result_queue.get()))
         return results
     
+    @staticmethod
+    def _task_results(item) -> List[Dict]:
+        """The results of a finished task, raising the error of a failed one."""
+        if isinstance(item, WorkerError):
+            raise item
+        return item
+    
+    def next_results(self, block: bool = True) -> List[Dict]:
+        """
+        Get the results of the next finished task, waiting for one if block is
+        set. Without block, an empty list means no task has finished.
+        """
+        try:
+            return self._task_results(self.result_queue.get(block=block))
+        except queue.Empty:
+            return []
+    
     def wait(self):
         """Wait for all tasks to complete."""
         self.task_queue.join()
+        for worker_queue in self.worker_queues:
+            worker_queue.join()
+    
+    def load_report(self) -> List[str]:
+        """
+        Describe how the work was spread over the workers: tasks, points and
+        iterations of each, its busy time, and the imbalance as the largest
+        busy time over the mean (1.00 is perfectly even).
+        """
+        lines = [f"Load balance over {len(self.workers)} workers:"]
+        for index in range(len(self.workers)):
+            lines.append(f"  worker {index}: {self.task_counts[index]} tasks, "
+                         f"{self.point_counts[index]} points, "
+                         f"{self.iteration_counts[index]} iterations, "
+                         f"busy {self.busy_time[index]:.2f} s")
+        mean_busy = sum(self.busy_time) / len(self.workers)
+        if mean_busy > 0:
+            lines.append(f"  imbalance (max/mean busy time): {max(self.busy_time) / mean_busy:.2f}")
+        return lines
+    
+    def interior_points(self) -> int:
+        """Total number of points answered by the interior test in this run."""
+        return sum(worker.stats() for worker in self.workers)
     
     def close(self):
         """Close all workers and threads."""
         self.running = False
         
-        # Signal threads to stop
+        # Signal threads to stop, after any remaining task
         for _ in self.workers:
-            self.task_queue.put(None)
+            self._put(self.task_queue, float('-inf'), None)
         
         # Wait for threads
         for thread in self.worker_threads:
@@ -293,13 +647,852 @@ class MandelbrotPool:
         # Close workers
         for worker in self.workers:
             worker.close()
+    
+    def terminate(self):
+        """
+        Stop after a failure: kill the worker processes, so that threads
+        waiting for an answer give up, and drop the queued tasks.
+        """
+        self.running = False
+        for worker in self.workers:
+            worker.kill()
+        for thread in self.worker_threads:
+            thread.join()
+
+
+class BandResults:
+    """
+    Results of a band of consecutive grid points, point idx = first + i for
+    i < count (idx // resolution_cb is the column, idx % resolution_cb the row).
+    Numbers are kept in compact columns; only the final z of points that are
+    already decided is stored as base-32 text, and the z reached by undecided
+    points if the workers report it (for checkpoints). smooth is only filled
+    in for escaped points, and only when the workers report it.
+    """
+    
+    def __init__(self, first: int, count: int):
+        self.first = first
+        self.count = count
+        self.escaped = bytearray(count)                 # 1 once the point escaped
+        self.iterations = array('q', bytes(8 * count))  # Cumulative iterations
+        self.period = array('q', bytes(8 * count))      # Cycle length, 0 if none was found
+        self.worker = array('i', [-1]) * count          # Worker keeping the point's state, -1 if none
+        self.round = bytearray(count)                   # Adaptive round the point was last sent to
+        self.smooth = array('d', bytes(8 * count))      # Normalized iteration count of escaped points
+        self.final_za = ['0'] * count
+        self.final_zb = ['0'] * count
+    
+    def restore(self, checkpoint: Checkpoint):
+        """Take the point state of the band saved in a checkpoint."""
+        self.escaped[:] = checkpoint.escaped
+        self.round[:] = checkpoint.round
+        self.iterations = checkpoint.iterations
+        self.period = checkpoint.period
+        self.smooth = checkpoint.smooth
+        self.final_za = checkpoint.final_za
+        self.final_zb = checkpoint.final_zb
+
+
+class CsvOutput:
+    """
+    Write bands of results as CSV rows, in index order. With smooth, a SMOOTH
+    column holds the normalized iteration count of escaped points (empty for
+    the others). With resume_offset, an existing file is continued after its
+    first resume_offset bytes (a position() of the earlier run).
+    """
+    
+    def __init__(self, output_path: str, ca_values: List[str], cb_values: List[str],
+                 smooth: bool = False, resume_offset: Optional[int] = None):
+        self.ca_values = ca_values
+        self.cb_values = cb_values
+        self.smooth = smooth
+        if resume_offset is not None:
+            self.csvfile = open(output_path, 'r+', newline='')
+            self.csvfile.truncate(resume_offset)
+            self.csvfile.seek(resume_offset)
+            self.writer = csv.writer(self.csvfile)
+            return
+        self.csvfile = open(output_path, 'w', newline='')
+        self.writer = csv.writer(self.csvfile)
+        header = ['X', 'Y', 'CA', 'CB', 'ESCAPED', 'ITERATIONS', 'FINAL_ZA', 'FINAL_ZB', 'PERIOD']
+        self.writer.writerow(header + ['SMOOTH'] if smooth else header)
+    
+    def write_band(self, band: BandResults):
+        resolution_cb = len(self.cb_values)
+        for i in range(band.count):
+            x, y = divmod(band.first + i, resolution_cb)
+            row = [x, y, self.ca_values[x], self.cb_values[y],
+                   'Y' if band.escaped[i] else 'N', band.iterations[i],
+                   band.final_za[i], band.final_zb[i], band.period[i]]
+            if self.smooth:
+                row.append(repr(band.smooth[i]) if band.escaped[i] else '')
+            self.writer.writerow(row)
+    
+    def position(self) -> int:
+        """Flush the rows written so far and return the size of the file."""
+        self.csvfile.flush()
+        return self.csvfile.tell()
+    
+    def close(self):
+        self.csvfile.close()
+
+
+class GridOutput:
+    """
+    Write bands of results in the binary grid format, with final z rounded to
+    floats and, if requested, the full-precision final z in the sidecar file
+    and the smooth iteration column. With resume_points, existing files are
+    continued after their first resume_points points.
+    """
+    
+    def __init__(self, output_path: str, min_ca: str, min_cb: str, max_ca: str, max_cb: str,
+                 escape_radius: str, precision: int, grid_precision: int,
+                 ca_values: List[str], cb_values: List[str], float32: bool, sidecar: bool,
+                 smooth: bool = False, resume_points: Optional[int] = None):
+        self.writer = GridFileWriter(output_path, min_ca, min_cb, max_ca, max_cb, escape_radius,
+                                     precision, grid_precision, ca_values, cb_values,
+                                     smooth=smooth, float64=not float32,
+                                     resume=resume_points is not None)
+        self.smooth = smooth
+        self.sidecar = SidecarWriter(output_path, self.writer.count,
+                                     resume_points or 0) if sidecar else None
+    
+    def write_band(self, band: BandResults):
+        # Parsing at 53 bits rounds the base-32 text to the nearest double
+        final_za = [float(parse_mpfr_base32(z, 53)) for z in band.final_za]
+        final_zb = [float(parse_mpfr_base32(z, 53)) for z in band.final_zb]
+        self.writer.write_points(band.first, band.escaped, band.iterations, band.period,
+                                 final_za, final_zb, band.smooth if self.smooth else None)
+        if self.sidecar is not None:
+            self.sidecar.write_points(band.final_za, band.final_zb)
+    
+    def position(self) -> int:
+        """Flush the points written so far; points have fixed places, so 0."""
+        self.writer.flush()
+        if self.sidecar is not None:
+            self.sidecar.flush()
+        return 0
+    
+    def close(self):
+        self.writer.close()
+        if self.sidecar is not None:
+            self.sidecar.close()
+
+
+class PreviousResults:
+    """
+    Read an earlier result of the same grid band by band, in index order,
+    for deepening. A CSV file keeps the full-precision final z; a binary grid
+    file only does so in its sidecar, which is therefore required. Raises
+    ValueError if the file does not hold this grid, or lacks the smooth
+    values that are to be written.
+    """
+    
+    CSV_COLUMNS = ['X', 'Y', 'CA', 'CB', 'ESCAPED', 'ITERATIONS', 'FINAL_ZA', 'FINAL_ZB', 'PERIOD']
+    
+    def __init__(self, path: str, ca_values: List[str], cb_values: List[str], smooth: bool):
+        self.ca_values = ca_values
+        self.cb_values = cb_values
+        self.smooth = smooth
+        self.grid = None
+        self.csvfile = None
+        if is_grid_file(path):
+            self.grid = GridFile(path)
+            if self.grid.ca_values != ca_values or self.grid.cb_values != cb_values:
+                raise ValueError(f"{path} holds a different grid")
+            if not self.grid.has_sidecar():
+                raise ValueError(f"{path} has no sidecar with the full-precision final z")
+            if smooth and self.grid.smooth is None:
+                raise ValueError(f"{path} has no smooth values")
+            self.next_x = 0
+            return
+        self.csvfile = open(path, newline='')
+        self.reader = csv.DictReader(self.csvfile)
+        fieldnames = self.reader.fieldnames or []
+        if fieldnames[:len(self.CSV_COLUMNS)] != self.CSV_COLUMNS:
+            raise ValueError(f"{path} is not a result file")
+        if smooth and 'SMOOTH' not in fieldnames:
+            raise ValueError(f"{path} has no SMOOTH column")
+    
+    def _read_grid_columns(self, band: Optional[BandResults], columns: int):
+        assert self.grid is not None
+        resolution_cb = len(self.cb_values)
+        for x in range(self.next_x, self.next_x + columns):
+            if band is None:
+                continue
+            start = x * resolution_cb - band.first
+            escaped = self.grid.escaped[x].tolist()
+            iterations = self.grid.iterations[x].tolist()
+            period = self.grid.period[x].tolist()
+            smooth = self.grid.smooth[x].tolist() if self.smooth else None
+            for y in range(resolution_cb):
+                i = start + y
+                band.escaped[i] = escaped[y]
+                band.iterations[i] = iterations[y]
+                band.period[i] = period[y]
+                if smooth is not None:
+                    band.smooth[i] = smooth[y]
+                band.final_za[i], band.final_zb[i] = self.grid.final_z_text(x, y)
+        self.next_x += columns
+    
+    def _read_csv_rows(self, band: Optional[BandResults], first: int, count: int):
+        resolution_cb = len(self.cb_values)
+        for idx in range(first, first + count):
+            row = next(self.reader, None)
+            x, y = divmod(idx, resolution_cb)
+            if (row is None or row['X'] != str(x) or row['Y'] != str(y) or
+                    row['CA'] != self.ca_values[x] or row['CB'] != self.cb_values[y]):
+                raise ValueError(f"Point ({x}, {y}) of the earlier result does not match the grid")
+            if band is None:
+                continue
+            i = idx - band.first
+            band.escaped[i] = row['ESCAPED'] == 'Y'
+            band.iterations[i] = int(row['ITERATIONS'])
+            band.period[i] = int(row['PERIOD'])
+            if self.smooth and row['SMOOTH']:
+                band.smooth[i] = float(row['SMOOTH'])
+            band.final_za[i] = row['FINAL_ZA']
+            band.final_zb[i] = row['FINAL_ZB']
+    
+    def read_band(self, band: BandResults):
+        """Fill a band (the next one in index order) with the earlier results."""
+        if self.grid is not None:
+            self._read_grid_columns(band, band.count // len(self.cb_values))
+        else:
+            self._read_csv_rows(band, band.first, band.count)
+    
+    def skip(self, first: int, count: int):
+        """Pass over count points starting at point first, in whole columns."""
+        if self.grid is not None:
+            self._read_grid_columns(None, count // len(self.cb_values))
+        else:
+            self._read_csv_rows(None, first, count)
+    
+    def close(self):
+        if self.csvfile is not None:
+            self.csvfile.close()
+
+
+def deepen_band(band: BandResults, start_max_iterations: int):
+    """
+    Prepare a band read from an earlier result for calculate_band(): every
+    point that is neither escaped nor periodic gets the first adaptive round
+    (limit start_max_iterations * 2^r) above the iterations it has done, and
+    continues from its final z. A point with final z exactly 0 was filled by
+    subdivision rather than iterated, so it starts again from z0 = 0.
+    """
+    for i in range(band.count):
+        if band.escaped[i] or band.period[i] != 0:
+            continue
+        if band.final_za[i] == '0' and band.final_zb[i] == '0':
+            band.iterations[i] = 0
+        r = 0
+        while band.iterations[i] and start_max_iterations * 2 ** r <= band.iterations[i]:
+            r += 1
+        band.round[i] = r
+
+
+class CheckpointWriter:
+    """
+    Save checkpoints of a calculation (py_common/checkpoint_file.py) for
+    --resume. A checkpoint is saved after every band that has been written
+    out, and in between at most every interval seconds with the state of
+    the band in progress.
+    
+    The caller only copies the band columns; the file is written by a
+    background thread, so the workers keep getting tasks meanwhile. A band
+    checkpoint that comes due while the previous one is still being written
+    is skipped.
+    """
+    
+    def __init__(self, path: str, key: str, interval: float,
+                 points_written: int = 0, output_offset: int = 0):
+        self.path = path
+        self.key = key
+        self.interval = interval
+        self.points_written = points_written
+        self.output_offset = output_offset
+        self.last_save = time.monotonic()
+        self.thread: Optional[threading.Thread] = None
+    
+    def _write(self, checkpoint: Checkpoint):
+        try:
+            write_checkpoint(self.path, checkpoint)
+        except OSError as e:
+            print(f"Warning: could not write checkpoint {self.path}: {e}", file=sys.stderr)
+    
+    def _save(self, checkpoint: Checkpoint):
+        # Checkpoints are written in order, one at a time
+        if self.thread is not None:
+            self.thread.join()
+        self.thread = threading.Thread(target=self._write, args=(checkpoint,))
+        self.thread.start()
+        self.last_save = time.monotonic()
+    
+    def due(self) -> bool:
+        """Check whether a band checkpoint should be saved now."""
+        return (time.monotonic() - self.last_save >= self.interval and
+                (self.thread is None or not self.thread.is_alive()))
+    
+    def save_band(self, band: BandResults, judged: int, returned: List[int],
+                  escaped: List[int], rounds: bytearray):
+        """
+        Save the state of a band in progress: the rounds judged so far, the
+        counters of every round and, per point, the round it has to run next.
+        """
+        self._save(Checkpoint(self.key, self.points_written, self.output_offset,
+                              band.first, band.count, judged,
+                              array('q', returned), array('q', escaped),
+                              bytes(band.escaped), bytes(rounds),
+                              array('q', band.iterations), array('q', band.period),
+                              array('d', band.smooth),
+                              list(band.final_za), list(band.final_zb)))
+    
+    def output_done(self, points_written: int, output_offset: int):
+        """Save a checkpoint after the output holds points_written points."""
+        self.points_written = points_written
+        self.output_offset = output_offset
+        self._save(Checkpoint(self.key, points_written, output_offset))
+    
+    def close(self):
+        """Wait for the last checkpoint and remove it: the calculation is complete."""
+        if self.thread is not None:
+            self.thread.join()
+        if os.path.exists(self.path):
+            os.remove(self.path)
+
+
+class NewPointScheduler:
+    """
+    Hands the new points of a band to the pool in tasks, most expensive first.
+    
+    The cost of a point is estimated from its finished neighbors: the largest
+    number of iterations one of its 8 neighbors needed (the whole budget if the
+    neighbor did not escape). Points without a finished neighbor yet are handed
+    out coarse to fine (every 2^k-th column and row first), so estimates soon
+    exist all over the band; they go after points known to be expensive and
+    before points known to be cheap. Points are grouped into tasks of about the
+    same estimated cost, so cheap points travel in large batches and expensive
+    ones are spread over the workers.
+    """
+    
+    # Estimated cost of one task, in whole budgets
+    TASK_BUDGETS = 8
+    
+    def __init__(self, band: BandResults, resolution_cb: int, budget: int, indices: List[int]):
+        self.band = band
+        self.resolution_cb = resolution_cb
+        self.budget = budget
+        self.pending = bytearray(band.count)            # 1 while a point waits
+        for i in indices:
+            self.pending[i] = 1
+        self.remaining = len(indices)
+        self.estimate = array('q', [-1]) * band.count   # -1 while unknown
+        self.known: List[Tuple[int, int]] = []          # Heap of (-estimate, i)
+        
+        first_column = band.first // resolution_cb
+        
+        def coarseness(i: int) -> Tuple[int, int]:
+            # Largest power of two dividing both the column (within the band) and the row
+            x, y = divmod(band.first + i, resolution_cb)
+            x -= first_column
+            return (min(x & -x if x else 1 << 62, y & -y if y else 1 << 62), -i)
+        
+        # Taken from the end: coarsest first, grid order within a level
+        self.unknown = sorted(indices, key=coarseness)
+    
+    def point_done(self, i: int, iterations: int, undecided: bool):
+        """Record the result of point i for the estimates of its neighbors."""
+        cost = self.budget if undecided else iterations
+        y = (self.band.first + i) % self.resolution_cb
+        for dx in (-1, 0, 1):
+            for dy in (-1, 0, 1):
+                if (dx == 0 and dy == 0) or not 0 <= y + dy < self.resolution_cb:
+                    continue
+                j = i + dx * self.resolution_cb + dy
+                if 0 <= j < self.band.count and self.pending[j] and cost > self.estimate[j]:
+                    self.estimate[j] = cost
+                    heapq.heappush(self.known, (-cost, j))
+    
+    def _next_point(self, guess: int) -> int:
+        # Drop heap entries of points handed out or re-estimated since
+        while self.known and (not self.pending[self.known[0][1]]
+                              or -self.known[0][0] != self.estimate[self.known[0][1]]):
+            heapq.heappop(self.known)
+        while self.unknown and not self.pending[self.unknown[-1]]:
+            self.unknown.pop()
+        
+        if self.known and (-self.known[0][0] >= guess or not self.unknown):
+            i = heapq.heappop(self.known)[1]
+        else:
+            i = self.unknown.pop()
+        self.pending[i] = 0
+        self.remaining -= 1
+        return i
+    
+    def next_task(self, max_points: int) -> Tuple[List[int], int]:
+        """Take the next points to send as one task; returns (points, estimated cost)."""
+        guess = self.budget // 2                # Points without an estimate
+        floor = max(1, self.budget // 64)       # Even a free point costs a record
+        target = self.TASK_BUDGETS * self.budget
+        points = []
+        cost = 0
+        while self.remaining and cost < target and len(points) < max_points:
+            i = self._next_point(guess)
+            points.append(i)
+            cost += max(floor, guess if self.estimate[i] < 0 else self.estimate[i])
+        return points, cost
+
+
+def calculate_band(pool: MandelbrotPool, band: BandResults, resolution_cb: int,
+                   precision: int, start_max_iterations: int, escape_radius: str,
+                   indices: Optional[List[int]] = None,
+                   mirror_rows: Optional['array[int]'] = None,
+                   checkpoints: Optional[CheckpointWriter] = None,
+                   resume: Optional[Checkpoint] = None):
+    """
+    Run the adaptive iteration rounds for the points of one band (or only the
+    band points listed in indices) until they are decided, then release the
+    points still kept by the workers so that the band holds every final z.
+    The stopping rules apply to the points calculated in this call.
+    
+    With mirror_rows (from find_mirror_rows()), a point in a mirrored row is
+    not iterated: its source point in the same column is calculated instead,
+    and the point gets a copy of its results with FINAL_ZB negated.
+    
+    Round r runs every undecided point to max_iterations = start_max_iterations * 2^r
+    cumulative iterations. There is no barrier between rounds: as soon as a point
+    comes back undecided it is sent on to the next round, while other points are
+    still in earlier rounds. A round is judged by the stopping rules once its
+    last point is back. Points may run at most one round ahead of the oldest
+    round not yet judged; further ahead they wait, so a stop wastes at most
+    one round of work. Points already past a stopping round keep their extra
+    iterations.
+    
+    With checkpoints, the state of the band is saved whenever a checkpoint is
+    due (the workers must report the z of kept points). With resume, the band
+    has been restored from such a checkpoint: judged rounds stay judged, and
+    every undecided point runs its round again from the z it had reached,
+    so the work of rounds still in progress at the time is redone. A band
+    prepared by deepen_band() is resumed the same way, with no rounds judged.
+    """
+    max_total_iterations = 10000000  # Safety limit
+    
+    def round_limit(r: int) -> int:
+        return start_max_iterations * 2 ** r
+    
+    # Per round: points sent, points back, points that escaped, and points
+    # waiting to be sent because the round is too far ahead
+    sent = [0]
+    returned = [0]
+    escaped = [0]
+    waiting: List[List[int]] = [[]]
+    judged = 0          # Rounds before this one have been judged and passed
+    stopped = False
+    limit_reached = False
+    outstanding = 0     # Points sent whose result has not arrived yet
+    continuing: Dict[int, List[Tuple[int, int]]] = {}
+    restarting: Dict[int, List[Tuple[int, int, int, str, str]]] = {}
+    over_limit: List[Tuple[int, int]] = []  # Undecided points and a next round past the limit
+    
+    def add_rounds(r: int):
+        while len(sent) <= r:
+            sent.append(0)
+            returned.append(0)
+            escaped.append(0)
+            waiting.append([])
+    
+    def send_to_round(i: int, r: int):
+        # The worker process keeps z; run only the iterations the point has not done
+        band.round[i] = r
+        sent[r] += 1
+        more = round_limit(r) - band.iterations[i]
+        if band.worker[i] >= 0:
+            continuing.setdefault(band.worker[i], []).append((band.first + i, more))
+        else:
+            # Restored from a checkpoint: no process keeps it, so start from its z
+            restarting.setdefault(more, []).append(
+                (band.first + i, *divmod(band.first + i, resolution_cb),
+                 band.final_za[i], band.final_zb[i]))
+    
+    def submit_rounds():
+        nonlocal outstanding
+        for worker_index, records in continuing.items():
+            pool.submit_continue(worker_index, records)
+            outstanding += len(records)
+        for more, records in restarting.items():
+            pool.submit_grid_batch(precision, more, escape_radius, records, True)
+            outstanding += len(records)
+        continuing.clear()
+        restarting.clear()
+    
+    points = range(band.count) if indices is None else indices
+    mirrored: List[int] = []
+    if mirror_rows is not None:
+        sources = set()
+        for i in points:
+            source = mirror_source(band, resolution_cb, mirror_rows, i)
+            if source != i:
+                mirrored.append(i)
+            sources.add(source)
+        points = sorted(sources)
+    
+    if resume is not None:
+        judged = resume.judged
+        add_rounds(len(resume.returned) - 1)
+        returned[:len(resume.returned)] = resume.returned
+        escaped[:len(resume.returned)] = resume.escaped_counts
+        sent[:len(resume.returned)] = resume.returned
+        # Points that had started run their next round again from their z
+        for i in points:
+            r = band.round[i]
+            if band.escaped[i] or band.period[i] != 0 or band.iterations[i] == 0:
+                continue
+            if round_limit(r) > max_total_iterations:
+                limit_reached = True
+                over_limit.append((i, r))
+                continue
+            add_rounds(r)
+            if r <= judged + 1:
+                send_to_round(i, r)
+            else:
+                waiting[r].append(i)
+        submit_rounds()
+    
+    # Round 0: new points are sent by pixel only, a few tasks at a time so
+    # that the scheduler can order the rest by what their neighbors cost
+    scheduler = NewPointScheduler(band, resolution_cb, round_limit(0), [
+        i for i in points
+        if not band.escaped[i] and band.period[i] == 0 and band.iterations[i] == 0
+    ])
+    sent[0] += scheduler.remaining
+    
+    def next_rounds() -> bytearray:
+        # Points in flight run their round again; waiting points go to their round
+        rounds = bytearray(band.round)
+        for r, waiting_points in enumerate(waiting):
+            for i in waiting_points:
+                rounds[i] = r
+        for i, r in over_limit:
+            rounds[i] = r
+        return rounds
+    
+    def feed_new_points():
+        nonlocal outstanding
+        while scheduler.remaining and pool.queued_tasks() < 2 * len(pool.workers):
+            points, cost = scheduler.next_task(pool.MAX_CHEAP_BATCH_SIZE)
+            records = [(band.first + i, *divmod(band.first + i, resolution_cb)) for i in points]
+            pool.submit_grid_task(precision, start_max_iterations, escape_radius, records,
+                                  True, cost)
+            outstanding += len(points)
+    
+    def judge_rounds():
+        # Judge every round whose points are all back, in order; the points of
+        # a round only all exist once the round before it has been judged. A
+        # round no point ran in (possible after resume) passes silently.
+        nonlocal judged, stopped
+        while not stopped and judged < len(sent) and returned[judged] == sent[judged]:
+            processed = sent[judged]
+            newly_escaped = escaped[judged]
+            if processed > 0:
+                print(f"Iteration round: max_iterations={round_limit(judged)}, processed {processed} points",
+                      file=sys.stderr)
+                
+                # Check if no points escaped in this round
+                if newly_escaped == 0:
+                    print(f"No new escaped points after {processed} iterations, stopping", file=sys.stderr)
+                    stopped = True
+                    break
+                
+                # Check if less than 1% escaped
+                escape_percentage = (newly_escaped / processed) * 100
+                if escape_percentage < 1.0:
+                    print(f"Less than 1% of points escaped ({escape_percentage:.2f}%), stopping", file=sys.stderr)
+                    stopped = True
+                    break
+                
+                print(f"Points escaped in this round: {newly_escaped}/{processed} ({escape_percentage:.2f}%)", file=sys.stderr)
+            judged += 1
+            
+            # The next round may now start its waiting points
+            if judged + 1 < len(waiting):
+                for i in waiting[judged + 1]:
+                    send_to_round(i, judged + 1)
+                waiting[judged + 1] = []
+    
+    judge_rounds()
+    submit_rounds()
+    feed_new_points()
+    while outstanding > 0:
+        # Take every result that is ready (waiting for the first one), then send
+        # the continuations it produced as one CONTINUE batch per worker: points
+        # whose state is kept by a worker process only get a CONTINUE by id, so
+        # neither c nor z travels as text
+        results = pool.next_results()
+        while True:
+            more = pool.next_results(block=False)
+            if not more:
+                break
+            results.extend(more)
+        
+        for res in results:
+            i = res['idx'] - band.first
+            r = band.round[i]
+            outstanding -= 1
+            returned[r] += 1
+            band.iterations[i] += res['iterations']
+            if r == 0:
+                scheduler.point_done(i, res['iterations'], res['escaped'] == 'K')
+            
+            # Still undecided: move on to the next round
+            if res['escaped'] == 'K':
+                band.worker[i] = res['worker']
+                if 'final_za' in res:
+                    band.final_za[i] = res['final_za']
+                    band.final_zb[i] = res['final_zb']
+                if stopped:
+                    continue
+                if round_limit(r + 1) > max_total_iterations:
+                    limit_reached = True
+                    over_limit.append((i, r + 1))
+                    continue
+                add_rounds(r + 1)
+                if r + 1 <= judged + 1:
+                    send_to_round(i, r + 1)
+                else:
+                    waiting[r + 1].append(i)
+                continue
+            band.worker[i] = -1
+            band.final_za[i] = res['final_za']
+            band.final_zb[i] = res['final_zb']
+            
+            # A periodic orbit never escapes: keep 'N' and record the period
+            if res['escaped'] == 'P':
+                band.period[i] = res['period']
+            elif res['escaped'] == 'Y':
+                band.escaped[i] = 1
+                escaped[r] += 1
+                if 'smooth' in res:
+                    # The worker counts from the start of this command only
+                    band.smooth[i] = band.iterations[i] - res['iterations'] + res['smooth']
+        
+        judge_rounds()
+        
+        # After a stop, undecided points stay kept and are dropped below
+        if stopped:
+            continuing.clear()
+            restarting.clear()
+        else:
+            submit_rounds()
+        feed_new_points()
+        
+        if checkpoints is not None and not stopped and checkpoints.due():
+            checkpoints.save_band(band, judged, returned, escaped, next_rounds())
+    
+    if limit_reached and not stopped:
+        print("Reached maximum iteration limit", file=sys.stderr)
+    elif not stopped:
+        print("All points processed", file=sys.stderr)
+    
+    # Release the points still kept by the workers and fetch their final z
+    kept: Dict[int, List[int]] = {}
+    for i in range(band.count):
+        if band.worker[i] >= 0:
+            kept.setdefault(band.worker[i], []).append(band.first + i)
+    for worker_index, indices in kept.items():
+        pool.submit_drop(worker_index, indices)
+    pool.wait()
+    for res in pool.get_results(sum(len(indices) for indices in kept.values())):
+        i = res['idx'] - band.first
+        band.worker[i] = -1
+        band.final_za[i] = res['final_za']
+        band.final_zb[i] = res['final_zb']
+    
+    for i in mirrored:
+        copy_mirrored(band, i, mirror_source(band, resolution_cb, mirror_rows, i))
+
+
+# Rectangles with fewer columns or rows than this between their borders are
+# calculated point by point
+MARIANI_SILVER_MIN_SIZE = 4
+
+
+def subdivide_band(pool: MandelbrotPool, band: BandResults, resolution_cb: int,
+                   precision: int, start_max_iterations: int, escape_radius: str,
+                   verify_samples: int, rng: random.Random,
+                   mirror_rows: Optional['array[int]'] = None) -> Tuple[int, int]:
+    """
+    Calculate a band with Mariani-Silver subdivision. Only the border of a
+    rectangle is calculated; if every border point has the same result (all in
+    the set, or all escaped after the same number of iterations), the inside is
+    filled with it without iterating, otherwise the rectangle is split in four
+    along its middle column and row, whose points are the only new ones to
+    calculate. Rectangles too small to be worth it are calculated point by point.
+    
+    With verify_samples, that many random inside points of a rectangle are
+    calculated before it is filled, and the rectangle is split instead if any
+    of them disagrees with its border.
+    
+    Filled points take the escaped flag and iterations of the border (the
+    largest border iterations for points in the set), its period if all border
+    points share one, the mean smooth value of the border if it escaped, and a
+    final z of 0. Each level of subdivision is one
+    calculate_band() call over all the points it needs, so the workers get
+    large batches. Returns (filled points, rectangles rejected by verification).
+    
+    mirror_rows is passed on to calculate_band(); a mirrored point is only
+    ever given the results of a calculated source point, never filled ones.
+    Filled points of mirrored rows are finally replaced by their source's
+    results, so the band stays symmetric.
+    """
+    columns = band.count // resolution_cb
+    computed = bytearray(band.count)
+    is_filled = bytearray(band.count)
+    filled = 0
+    rejected = 0
+    
+    def compute(indices: List[int]):
+        nonlocal filled
+        todo = sorted({i for i in indices if not computed[i]})
+        if todo:
+            sources = [mirror_source(band, resolution_cb, mirror_rows, i) for i in todo]
+            for source in sources:
+                if is_filled[source]:
+                    band.escaped[source] = 0
+                    band.iterations[source] = 0
+                    band.period[source] = 0
+                    band.smooth[source] = 0.0
+                    is_filled[source] = 0
+                    filled -= 1
+            calculate_band(pool, band, resolution_cb, precision, start_max_iterations,
+                           escape_radius, todo, mirror_rows)
+            for i, source in zip(todo, sources):
+                computed[i] = 1
+                computed[source] = 1
+    
+    def result(i: int) -> Tuple[int, int]:
+        # Points in the set (periodic or undecided) all count as one result
+        return (1, band.iterations[i]) if band.escaped[i] else (0, 0)
+    
+    def border(rect: Tuple[int, int, int, int]) -> List[int]:
+        x0, y0, x1, y1 = rect
+        points = [x * resolution_cb + y for x in (x0, x1) for y in range(y0, y1 + 1)]
+        points += [x * resolution_cb + y for x in range(x0 + 1, x1) for y in (y0, y1)]
+        return points
+    
+    def inside(rect: Tuple[int, int, int, int]) -> List[int]:
+        x0, y0, x1, y1 = rect
+        return [x * resolution_cb + y for x in range(x0 + 1, x1) for y in range(y0 + 1, y1)]
+    
+    def split(rect: Tuple[int, int, int, int]) -> List[Tuple[int, int, int, int]]:
+        # Children share the middle column and row
+        x0, y0, x1, y1 = rect
+        xm = (x0 + x1) // 2
+        ym = (y0 + y1) // 2
+        return [(x0, y0, xm, ym), (xm, y0, x1, ym), (x0, ym, xm, y1), (xm, ym, x1, y1)]
+    
+    def fill(rect: Tuple[int, int, int, int], edge: List[int]):
+        nonlocal filled
+        escaped = band.escaped[edge[0]]
+        iterations = max(band.iterations[i] for i in edge)
+        periods = {band.period[i] for i in edge}
+        period = periods.pop() if len(periods) == 1 else 0
+        smooth = sum(band.smooth[i] for i in edge) / len(edge) if escaped else 0.0
+        for i in inside(rect):
+            if not computed[i]:
+                band.escaped[i] = escaped
+                band.iterations[i] = iterations
+                band.period[i] = period
+                band.smooth[i] = smooth
+                is_filled[i] = 1
+                filled += 1
+    
+    # Rectangles are (x0, y0, x1, y1) in band columns and rows, borders included;
+    # each one waits with the inside points sampled for it (None if not sampled yet)
+    rectangles: List[Tuple[Tuple[int, int, int, int], Optional[List[int]]]] = [
+        ((0, 0, columns - 1, resolution_cb - 1), None)
+    ]
+    direct: List[int] = []
+    while rectangles:
+        needed = list(direct)
+        direct = []
+        for rect, samples in rectangles:
+            needed += border(rect)
+            if samples:
+                needed += samples
+        compute(needed)
+        
+        pending = []
+        for rect, samples in rectangles:
+            x0, y0, x1, y1 = rect
+            if x1 - x0 < MARIANI_SILVER_MIN_SIZE or y1 - y0 < MARIANI_SILVER_MIN_SIZE:
+                direct += inside(rect)
+                continue
+            edge = border(rect)
+            edge_result = result(edge[0])
+            if any(result(i) != edge_result for i in edge):
+                pending += [(child, None) for child in split(rect)]
+            elif samples is None and verify_samples > 0:
+                points = inside(rect)
+                pending.append((rect, rng.sample(points, min(verify_samples, len(points)))))
+            elif samples and any(result(i) != edge_result for i in samples):
+                rejected += 1
+                pending += [(child, None) for child in split(rect)]
+            else:
+                fill(rect, edge)
+        rectangles = pending
+    compute(direct)
+    for i in range(band.count):
+        source = mirror_source(band, resolution_cb, mirror_rows, i)
+        if source != i and not computed[i]:
+            copy_mirrored(band, i, source)
+    return filled, rejected
 
 
 def calculate_mandelbrot_grid(min_ca: str, max_ca: str, min_cb: str, max_cb: str,
                               resolution: int, start_max_iterations: int,
-                              escape_radius: str, output_path: str):
+                              escape_radius: str, output_path: str,
+                              output_format: str = 'csv', float32: bool = False,
+                              sidecar: bool = False, band_points: Optional[int] = None,
+                              subdivide: bool = False, verify_samples: int = 0,
+                              symmetry: bool = True, smooth: bool = False,
+                              checkpoint_interval: Optional[float] = None,
+                              resume: bool = False, deepen: Optional[str] = None):
     """
     Main calculation function that orchestrates the grid calculation.
+    output_format is 'csv' or 'grid' (the binary format of py_common/grid_file.py);
+    float32 and sidecar only apply to 'grid'.
+    
+    Without band_points the whole grid is one band. With band_points the grid is
+    streamed: it is calculated in bands of whole columns of about band_points
+    points, each written out as soon as it is decided, so memory does not grow
+    with the size of the grid.
+    
+    With subdivide, each band is calculated by Mariani-Silver subdivision
+    (subdivide_band()), checking verify_samples random points of every
+    rectangle before it is filled.
+    
+    With symmetry, rows that mirror another row across the real axis
+    (find_mirror_rows()) are not calculated but copied from it.
+    
+    With smooth, the workers compute the normalized iteration count of escaped
+    points, which is written as an extra column. Final z is only requested at
+    full precision if the output keeps it (CSV or a sidecar file); the binary
+    format alone stores floats, so the workers round it to 53 bits.
+    
+    With checkpoint_interval, checkpoints are saved to <output_path>.ckpt
+    (CheckpointWriter): after every band, and at most every
+    checkpoint_interval seconds within a band (not with subdivide, whose
+    bands are only checkpointed once written). With resume, a calculation
+    with the same arguments continues from that checkpoint: bands already
+    written are kept in the output, and the band in progress continues from
+    the state it was saved in. The checkpoint is removed once the grid is
+    complete.
+    
+    With deepen, the path of an earlier result of the same grid (PreviousResults),
+    its decided points are copied and its undecided ones continue from their
+    final z (deepen_band()), so a deeper start_max_iterations only costs the
+    extra iterations. Not with subdivide.
     """
     # Find mandelbrot executable
     script_dir = os.path.dirname(os.path.abspath(__file__))
@@ -309,137 +1502,165 @@ def calculate_mandelbrot_grid(min_ca: str, max_ca: str, min_cb: str, max_cb: str
         print(f"Error: mandelbrot executable not found at {mandelbrot_path}", file=sys.stderr)
         sys.exit(1)
     
-    # Generate grid (this also calculates resolutions)
-    grid, resolution_ca, resolution_cb = generate_grid(min_ca, max_ca, min_cb, max_cb, resolution)
-    total_points = len(grid)
+    # Describe the grid (this also calculates resolutions)
+    grid_precision, ca_values, cb_values = generate_grid(min_ca, max_ca, min_cb, max_cb, resolution)
+    resolution_ca = len(ca_values)
+    resolution_cb = len(cb_values)
+    total_points = resolution_ca * resolution_cb
     print(f"Grid size: {resolution_ca}x{resolution_cb} = {total_points} points", file=sys.stderr)
     
     # Calculate precision
     precision = calculate_precision(min_ca, max_ca, min_cb, max_cb, resolution_ca, resolution_cb)
     print(f"Using precision: {precision} bits", file=sys.stderr)
     
-    # Initialize results storage
-    results = {}
-    for idx, (ca, cb, x, y) in enumerate(grid):
-        results[idx] = {
-            'ca': ca,
-            'cb': cb,
-            'x': x,
-            'y': y,
-            'za': '0',
-            'zb': '0',
-            'escaped': 'N',
-            'iterations': 0
-        }
+    mirror_rows = None
+    if symmetry:
+        mirror_rows = find_mirror_rows(cb_values, precision)
+        mirrored = sum(1 for source in mirror_rows if source >= 0)
+        if mirrored:
+            print(f"Real-axis symmetry: {mirrored} of {resolution_cb} rows mirrored", file=sys.stderr)
+        else:
+            mirror_rows = None
+    
+    # Point idx is pixel (idx // resolution_cb, idx % resolution_cb), so a
+    # band of whole columns is a run of consecutive indices
+    if band_points is None:
+        band_columns = resolution_ca
+    else:
+        band_columns = max(1, band_points // resolution_cb)
+    
+    # Everything that decides the results and the layout of the output
+    checkpoint_file = checkpoint_path(output_path)
+    key = ' '.join(str(value) for value in (
+        min_ca, min_cb, max_ca, max_cb, resolution, start_max_iterations, escape_radius,
+        output_format, float32, sidecar, band_columns, subdivide, verify_samples, symmetry, smooth,
+        deepen))
+    restored = None
+    if resume:
+        try:
+            restored = read_checkpoint(checkpoint_file)
+        except (OSError, ValueError) as e:
+            print(f"Error: cannot resume from {checkpoint_file}: {e}", file=sys.stderr)
+            sys.exit(1)
+        if restored.key != key:
+            print(f"Error: {checkpoint_file} was saved by a calculation with different arguments",
+                  file=sys.stderr)
+            sys.exit(1)
+        print(f"Resuming after {restored.points_written} of {total_points} points",
+              file=sys.stderr)
+    
+    previous = None
+    if deepen is not None:
+        try:
+            previous = PreviousResults(deepen, ca_values, cb_values, smooth)
+        except (OSError, ValueError) as e:
+            print(f"Error: cannot deepen {deepen}: {e}", file=sys.stderr)
+            sys.exit(1)
+        print(f"Deepening {deepen}", file=sys.stderr)
     
     # Create worker pool
     num_workers = cpu_count()
     print(f"Starting {num_workers} worker processes", file=sys.stderr)
-    pool = MandelbrotPool(mandelbrot_path, num_workers)
+    short_z = output_format == 'grid' and not sidecar
+    pool = MandelbrotPool(mandelbrot_path, num_workers, smooth, short_z,
+                          checkpoint_interval is not None)
+    pool.set_grid(grid_precision, min_ca, min_cb, max_ca, max_cb, resolution_ca, resolution_cb)
     pool.start()
     
-    # Adaptive iteration loop
-    max_iterations = start_max_iterations
-    max_total_iterations = 10000000  # Safety limit
+    print(f"Writing results to {output_path}", file=sys.stderr)
+    if output_format == 'grid':
+        output = GridOutput(output_path, min_ca, min_cb, max_ca, max_cb, escape_radius,
+                            precision, grid_precision, ca_values, cb_values, float32, sidecar,
+                            smooth, restored.points_written if restored else None)
+    else:
+        output = CsvOutput(output_path, ca_values, cb_values, smooth,
+                           restored.output_offset if restored else None)
+    checkpoints = None
+    if checkpoint_interval is not None:
+        checkpoints = CheckpointWriter(checkpoint_file, key, checkpoint_interval,
+                                       restored.points_written if restored else 0,
+                                       output.position())
     
-    while True:
-        # Find points that haven't escaped and still need more iterations
-        # (we treat `max_iterations` as the target cumulative iterations for this round)
-        unescape_indices = [
-            idx for idx in range(total_points)
-            if results[idx]['escaped'] == 'N'
-            and results[idx]['iterations'] < max_total_iterations
-            and results[idx]['iterations'] < max_iterations
-        ]
-        
-        if not unescape_indices:
-            print("All points processed", file=sys.stderr)
-            break
-        
-        print(f"Iteration round: max_iterations={max_iterations}, processing {len(unescape_indices)} points", 
-              file=sys.stderr)
-        
-        # Submit tasks for unescape points. Send the number of iterations to run
-        # in this round (the difference between the target `max_iterations`
-        # and the point's current cumulative iterations), so we don't re-run
-        # iterations that were already performed.
-        for idx in unescape_indices:
-            r = results[idx]
-            iterations_to_run = int(max_iterations - r['iterations'])
-            if iterations_to_run <= 0:
-                continue
-            pool.submit(idx, precision, r['za'], r['zb'], r['ca'], r['cb'],
-                       iterations_to_run, escape_radius)
-        
-        # Wait and collect results
-        pool.wait()
-        batch_results = pool.get_results(len(unescape_indices))
-        
-        # Track number of newly escaped points
-        newly_escaped = 0
-        
-        # Update results
-        for res in batch_results:
-            idx = res['idx']
-            results[idx]['escaped'] = res['escaped']
-            results[idx]['final_za'] = res['final_za']
-            results[idx]['final_zb'] = res['final_zb']
-            results[idx]['iterations'] += res['iterations']
-            
-            # Count newly escaped points
-            if res['escaped'] == 'Y':
-                newly_escaped += 1
-            
-            # Update z0 for next iteration
-            results[idx]['za'] = res['final_za']
-            results[idx]['zb'] = res['final_zb']
-        
-        # Calculate escape percentage
-        escape_percentage = (newly_escaped / len(unescape_indices)) * 100
-        
-        # Check if no points escaped in this round
-        if newly_escaped == 0:
-            print(f"No new escaped points after {len(unescape_indices)} iterations, stopping", file=sys.stderr)
-            break
-        
-        # Check if less than 1% escaped
-        if escape_percentage < 1.0:
-            print(f"Less than 1% of points escaped ({escape_percentage:.2f}%), stopping", file=sys.stderr)
-            break
-        
-        print(f"Points escaped in this round: {newly_escaped}/{len(unescape_indices)} ({escape_percentage:.2f}%)", file=sys.stderr)
-        
-        # Double max_iterations for next round
-        max_iterations *= 2
-        
-        # Check if we've hit the limit
-        if max_iterations > max_total_iterations:
-            print("Reached maximum iteration limit", file=sys.stderr)
-            break
+    # Fixed seed: the same arguments sample the same points
+    rng = random.Random(0)
+    total_filled = 0
+    total_rejected = 0
+    
+    def deepen_failed(e: ValueError):
+        # Found while reading, with no task in the pool: stop the workers first
+        print(f"Error: cannot deepen {deepen}: {e}", file=sys.stderr)
+        output.close()
+        pool.close()
+        sys.exit(1)
+    
+    start_column = restored.points_written // resolution_cb if restored else 0
+    if previous is not None and start_column > 0:
+        try:
+            previous.skip(0, start_column * resolution_cb)
+        except ValueError as e:
+            deepen_failed(e)
+    try:
+        for first_column in range(start_column, resolution_ca, band_columns):
+            columns = min(band_columns, resolution_ca - first_column)
+            if band_columns < resolution_ca:
+                print(f"Band: columns {first_column}..{first_column + columns - 1} "
+                      f"of {resolution_ca}", file=sys.stderr)
+            band = BandResults(first_column * resolution_cb, columns * resolution_cb)
+            band_resume = None
+            if restored and restored.band_count and restored.band_first == band.first:
+                band.restore(restored)
+                band_resume = restored
+            if previous is not None:
+                try:
+                    if band_resume is not None:
+                        previous.skip(band.first, band.count)
+                    else:
+                        previous.read_band(band)
+                        deepen_band(band, start_max_iterations)
+                        band_resume = Checkpoint(key, band.first, 0)
+                except ValueError as e:
+                    deepen_failed(e)
+            if subdivide:
+                filled, rejected = subdivide_band(pool, band, resolution_cb, precision,
+                                                  start_max_iterations, escape_radius,
+                                                  verify_samples, rng, mirror_rows)
+                total_filled += filled
+                total_rejected += rejected
+            else:
+                calculate_band(pool, band, resolution_cb, precision, start_max_iterations,
+                               escape_radius, mirror_rows=mirror_rows, checkpoints=checkpoints,
+                               resume=band_resume)
+            output.write_band(band)
+            if checkpoints is not None:
+                checkpoints.output_done(band.first + band.count, output.position())
+    except WorkerError as e:
+        # The last checkpoint saved is kept for --resume
+        print(f"Error: {e}", file=sys.stderr)
+        output.close()
+        pool.terminate()
+        sys.exit(1)
+    
+    output.close()
+    if previous is not None:
+        previous.close()
+    if checkpoints is not None:
+        checkpoints.close()
+    elif restored is not None:
+        os.remove(checkpoint_file)
+    
+    if subdivide:
+        print(f"Subdivision filled {total_filled} of {total_points} points "
+              f"({100 * total_filled / total_points:.1f}%) without iterating", file=sys.stderr)
+        if verify_samples > 0:
+            print(f"Verification rejected {total_rejected} rectangles", file=sys.stderr)
+    
+    print(f"Interior test short-circuited {pool.interior_points()} points", file=sys.stderr)
+    for line in pool.load_report():
+        print(line, file=sys.stderr)
     
     # Close pool
     pool.close()
     
-    # Write results to CSV
-    print(f"Writing results to {output_path}", file=sys.stderr)
-    with open(output_path, 'w', newline='') as csvfile:
-        fieldnames = ['X', 'Y', 'CA', 'CB', 'ESCAPED', 'ITERATIONS', 'FINAL_ZA', 'FINAL_ZB']
-        writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
-        writer.writeheader()
-        
-        for idx in range(total_points):
-            r = results[idx]
-            writer.writerow({
-                'X': r['x'],
-                'Y': r['y'],
-                'CA': r['ca'],
-                'CB': r['cb'],
-                'ESCAPED': r['escaped'],
-                'ITERATIONS': r['iterations'],
-                'FINAL_ZA': r['final_za'],
-                'FINAL_ZB': r['final_zb']
-            })
-    
     print("Calculation complete!", file=sys.stderr)
 
 
@@ -468,13 +1689,63 @@ Example:
     parser.add_argument('escape_radius', type=str,
                         help='Escape radius in MPFR base-32 format')
     parser.add_argument('output_path', type=str,
-                        help='Output CSV file path')
+                        help='Output file path')
+    parser.add_argument('--format', choices=['csv', 'grid'], default='csv',
+                        help='Output format: CSV text or the binary grid format (default: csv)')
+    parser.add_argument('--float32', action='store_true',
+                        help='Binary format only: store final z as float32 instead of float64')
+    parser.add_argument('--sidecar', action='store_true',
+                        help='Binary format only: also write the full-precision final z '
+                             'to <output_path>.z32')
+    parser.add_argument('--stream', action='store_true',
+                        help='Calculate and write the grid in bands of whole columns, so memory '
+                             'does not grow with the grid size')
+    parser.add_argument('--band-points', type=int, default=65536,
+                        help='With --stream: approximate number of points per band (default: 65536)')
+    parser.add_argument('--subdivide', action='store_true',
+                        help='Mariani-Silver subdivision: calculate rectangle borders and fill '
+                             'rectangles whose whole border has the same result')
+    parser.add_argument('--verify-samples', type=int, default=0,
+                        help='With --subdivide: random inside points to calculate before a '
+                             'rectangle is filled; it is split instead if one disagrees (default: 0)')
+    parser.add_argument('--no-symmetry', action='store_true',
+                        help='Calculate rows that mirror another row across the real axis '
+                             'instead of copying them')
+    parser.add_argument('--smooth', action='store_true',
+                        help='Also write the normalized iteration count of escaped points, '
+                             'computed by the workers, for smooth coloring')
+    parser.add_argument('--checkpoint-interval', type=float, default=None, metavar='SECONDS',
+                        help='Save the progress to <output_path>.ckpt after every band and at '
+                             'most every SECONDS seconds within a band')
+    parser.add_argument('--resume', action='store_true',
+                        help='Continue a killed calculation from <output_path>.ckpt; the other '
+                             'arguments must be the same as for that calculation')
+    parser.add_argument('--deepen', type=str, default=None, metavar='PATH',
+                        help='Continue the undecided points of an earlier result of the same grid '
+                             '(CSV, or binary with its sidecar) from their final z, and copy the '
+                             'decided ones')
     
     args = parser.parse_args()
+    if args.band_points < 1:
+        parser.error("--band-points must be at least 1")
+    if args.verify_samples < 0:
+        parser.error("--verify-samples must not be negative")
+    if args.checkpoint_interval is not None and args.checkpoint_interval <= 0:
+        parser.error("--checkpoint-interval must be positive")
+    if args.deepen is not None:
+        if args.subdivide:
+            parser.error("--deepen cannot be combined with --subdivide")
+        if (os.path.exists(args.deepen) and os.path.exists(args.output_path) and
+                os.path.samefile(args.deepen, args.output_path)):
+            parser.error("--deepen must not read the output file")
     
     calculate_mandelbrot_grid(args.min_ca, args.max_ca, args.min_cb, args.max_cb,
                              args.resolution, args.start_max_iterations,
-                             args.escape_radius, args.output_path)
+                             args.escape_radius, args.output_path,
+                             args.format, args.float32, args.sidecar,
+                             args.band_points if args.stream else None,
+                             args.subdivide, args.verify_samples, not args.no_symmetry,
+                             args.smooth, args.checkpoint_interval, args.resume, args.deepen)
 
 
 if __name__ == '__main__':
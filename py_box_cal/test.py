@@ -1,13 +1,93 @@
 #!/usr/bin/env python3
 """
 Simple test script for the Mandelbrot grid calculator.
-Tests basic functionality with a small grid.
+Tests basic functionality with a small grid, then the worker protocol and
+that the calculation modes agree with each other.
 """
 
 import os
 import sys
 import subprocess
 import csv
+import threading
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+MANDELBROT_PATH = os.path.join(os.path.dirname(SCRIPT_DIR), 'c_cal', 'mandelbrot')
+BOX_CALCULATOR = os.path.join(SCRIPT_DIR, 'box_calculator.py')
+
+# 27x40 grid whose every point is decided in the first round, so its results
+# cannot depend on how rounds, bands or rectangles are scheduled. Its columns
+# are odd multiples of 1/32, which keeps parabolic points such as -0.75 and
+# 0.25 (never decided) off the grid.
+DECIDED_GRID = ["-1.5", "-1.8", "0.h", "1.8", "27", "100000", "2"]
+# The same grid with rows shifted by half a step: the real axis falls between
+# two rows, and the rows do not extend equally far on either side of it
+DECIDED_GRID_OFF_AXIS = ["-1.5", "-1.1", "0.h", "1.f", "27", "100000", "2"]
+
+# Grids right of the cusp at 1/4 whose points all escape or lie in the main
+# cardioid, so no cycle is found by iterating: the iteration at which one
+# is noticed depends on how the iterations were split into commands. Given
+# as (min_ca, min_cb, max_ca, max_cb, resolution) with a shallow and a deep
+# start_max_iterations. The second grid needs 1024 bits, so its restart
+# records are longer than a pipe holds.
+DEEPEN_GRIDS = [
+    (["0.7", "-0.2", "0.h", "0.2", "32"], "4", "100000"),
+    (["0.80g" + "0" * 191, "0", "0.80g" + "0" * 190 + "1", "0.000" + "0" * 190 + "1", "32"],
+     "16", "512"),
+]
+
+
+def run_calculator(arguments, output_path, options=(), timeout=300):
+    """
+    Run box_calculator.py on the positional arguments (without the output
+    path) with options. Returns its stderr, or None if it failed or did not
+    finish in time.
+    """
+    cmd = [sys.executable, BOX_CALCULATOR, *options, "--", *arguments, output_path]
+    try:
+        result = subprocess.run(cmd, capture_output=True, text=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        print(f"ERROR: {' '.join(options) or 'Calculation'} did not finish in {timeout} s")
+        return None
+    if result.returncode != 0:
+        print(f"ERROR: {' '.join(options) or 'Calculation'} failed with exit code "
+              f"{result.returncode}")
+        print(result.stderr)
+        return None
+    return result.stderr
+
+
+def run_patched(patch, arguments, output_path, options=(), timeout=120):
+    """
+    Run box_calculator.py like run_calculator(), in a Python process that
+    first executes patch with the module imported as box_calculator.
+    Returns the CompletedProcess, or None if it did not finish in time.
+    """
+    argv = [BOX_CALCULATOR, *options, "--", *arguments, output_path]
+    code = (f"import sys\nsys.path.insert(0, {SCRIPT_DIR!r})\nimport box_calculator\n"
+            f"{patch}\nsys.argv = {argv!r}\nbox_calculator.main()\n")
+    try:
+        return subprocess.run([sys.executable, "-c", code], capture_output=True, text=True,
+                              timeout=timeout)
+    except subprocess.TimeoutExpired:
+        return None
+
+
+def read_rows(path):
+    """Read the rows of a CSV output, header included."""
+    with open(path, newline='') as f:
+        return list(csv.reader(f))
+
+
+def same_files(expected_path, actual_path):
+    """Compare two output files byte for byte, reporting a difference."""
+    with open(expected_path, 'rb') as expected, open(actual_path, 'rb') as actual:
+        if expected.read() == actual.read():
+            return True
+    print(f"ERROR: {os.path.basename(actual_path)} differs from "
+          f"{os.path.basename(expected_path)}")
+    return False
 
 
 def run_test():
@@ -100,6 +180,287 @@ def run_test():
     return True
 
 
+def test_long_records():
+    """
+    Send one CAL_GRID batch whose records and KEEP_Z answers each carry z at
+    3000 bits, far more than a pipe holds in either direction; the worker
+    has to read the answers while it is still writing the records.
+    """
+    print("=" * 60)
+    print("Long records test")
+    print("=" * 60)
+    sys.path.insert(0, SCRIPT_DIR)
+    from box_calculator import MandelbrotWorker
+    
+    worker = MandelbrotWorker(MANDELBROT_PATH, keep_z=True)
+    worker.set_grid(3000, "-0.g", "-0.g", "0.g", "0.g", 16, 16)
+    z = "0.0" + "1" * 600
+    records = [(i, i // 16, i % 16, z, z) for i in range(256)]
+    results = []
+    thread = threading.Thread(
+        target=lambda: results.extend(worker.calculate_grid_batch(3000, 1, "2", records, True)),
+        daemon=True)
+    thread.start()
+    thread.join(60)
+    if thread.is_alive():
+        assert worker.process
+        worker.process.kill()
+        print("ERROR: Batch did not complete, the pipes are deadlocked")
+        return False
+    worker.close()
+    
+    if len(results) != len(records) or any(r['escaped'] != 'K' for r in results):
+        print(f"ERROR: Expected {len(records)} kept points, got {len(results)} results")
+        return False
+    print(f"{len(results)} records of {len(' '.join(records[0][3:]))} characters answered")
+    print("✓ Test PASSED")
+    return True
+
+
+def test_streaming():
+    """
+    A grid streamed in bands of a few columns gives the same CSV, binary grid
+    and sidecar as the same grid calculated as one band.
+    """
+    print("=" * 60)
+    print("Streaming test")
+    print("=" * 60)
+    with tempfile.TemporaryDirectory() as tmp:
+        paths = {}
+        for name, options in (("whole", ()), ("bands", ("--stream", "--band-points", "200"))):
+            csv_path = os.path.join(tmp, f"{name}.csv")
+            grid_path = os.path.join(tmp, f"{name}.grid")
+            stderr = run_calculator(DECIDED_GRID, csv_path, options)
+            if stderr is None or run_calculator(DECIDED_GRID, grid_path,
+                                                options + ("--format", "grid", "--sidecar")) is None:
+                return False
+            paths[name] = (csv_path, grid_path, grid_path + ".z32")
+        bands = stderr.count("Band:")
+        if bands < 2:
+            print(f"ERROR: Expected several bands, got {bands}")
+            return False
+        if not all(same_files(whole, streamed)
+                   for whole, streamed in zip(paths["whole"], paths["bands"])):
+            return False
+    print(f"{bands} bands match the single-band CSV, grid and sidecar")
+    print("✓ Test PASSED")
+    return True
+
+
+def test_worker_failure():
+    """
+    A batch that fails in a worker thread fails the whole run, instead of
+    leaving the main thread waiting for its results.
+    """
+    print("=" * 60)
+    print("Worker failure test")
+    print("=" * 60)
+    patch = """
+original = box_calculator.MandelbrotWorker.calculate_grid_batch
+calls = []
+def calculate_grid_batch(self, *args, **kwargs):
+    calls.append(1)
+    if len(calls) == 3:
+        raise ValueError("injected failure")
+    return original(self, *args, **kwargs)
+box_calculator.MandelbrotWorker.calculate_grid_batch = calculate_grid_batch
+"""
+    with tempfile.TemporaryDirectory() as tmp:
+        result = run_patched(patch, DECIDED_GRID, os.path.join(tmp, "failed.csv"), timeout=60)
+    if result is None:
+        print("ERROR: The run did not stop after the worker failed")
+        return False
+    if result.returncode != 1 or "injected failure" not in result.stderr:
+        print(f"ERROR: Expected exit code 1 with the worker's error, got {result.returncode}")
+        print(result.stderr)
+        return False
+    print(result.stderr.strip().splitlines()[-1])
+    print("✓ Test PASSED")
+    return True
+
+
+def test_rounds():
+    """
+    Starting at 16 iterations, the points of the grid go through many
+    adaptive rounds, each running ahead of the others as its results come in.
+    A point's escape does not depend on how its iterations were split into
+    rounds, so every escaped point matches the single-round reference exactly,
+    and no point the reference found in the set escapes.
+    """
+    print("=" * 60)
+    print("Adaptive rounds test")
+    print("=" * 60)
+    with tempfile.TemporaryDirectory() as tmp:
+        reference_path = os.path.join(tmp, "reference.csv")
+        rounds_path = os.path.join(tmp, "rounds.csv")
+        if run_calculator(DECIDED_GRID, reference_path) is None:
+            return False
+        stderr = run_calculator(DECIDED_GRID[:5] + ["16"] + DECIDED_GRID[6:], rounds_path)
+        if stderr is None:
+            return False
+        reference = read_rows(reference_path)
+        rounds = read_rows(rounds_path)
+    
+    round_count = stderr.count("Iteration round:")
+    if round_count < 4:
+        print(f"ERROR: Expected several rounds, got {round_count}")
+        return False
+    escaped = [(expected, row) for expected, row in zip(reference, rounds) if row[4] == 'Y']
+    wrong = [row for expected, row in escaped if row != expected]
+    if len(rounds) != len(reference) or wrong:
+        print(f"ERROR: {len(wrong)} escaped points differ from the reference, e.g. {wrong[:1]}")
+        return False
+    print(f"{len(escaped)} points escaped over {round_count} rounds as in a single round")
+    print("✓ Test PASSED")
+    return True
+
+
+def test_subdivide():
+    """
+    Mariani-Silver subdivision fills rectangles of the grid that lie inside
+    the main cardioid or the period-2 bulb. Filled points get what the
+    interior test answers there (0 iterations, final z 0, the border's
+    period), so the output is the same as without subdivision, with and
+    without mirroring.
+    """
+    print("=" * 60)
+    print("Subdivision test")
+    print("=" * 60)
+    with tempfile.TemporaryDirectory() as tmp:
+        plain_path = os.path.join(tmp, "plain.csv")
+        if run_calculator(DECIDED_GRID, plain_path) is None:
+            return False
+        for options in (("--subdivide",), ("--subdivide", "--no-symmetry")):
+            path = os.path.join(tmp, "subdivided.csv")
+            stderr = run_calculator(DECIDED_GRID, path, options)
+            if stderr is None or not same_files(plain_path, path):
+                return False
+            filled = [line for line in stderr.splitlines() if line.startswith("Subdivision filled")]
+            if not filled or filled[0].split()[2] == "0":
+                print(f"ERROR: {' '.join(options)} filled no rectangle")
+                return False
+            print(f"{' '.join(options)}: {filled[0]}")
+    print("✓ Test PASSED")
+    return True
+
+
+def test_symmetry():
+    """
+    Rows copied across the real axis give the same output as calculating
+    them, for a grid with a row on the axis and for one whose axis falls
+    between rows, alone and with subdivision.
+    """
+    print("=" * 60)
+    print("Real-axis symmetry test")
+    print("=" * 60)
+    with tempfile.TemporaryDirectory() as tmp:
+        for grid in (DECIDED_GRID, DECIDED_GRID_OFF_AXIS):
+            for options in ((), ("--subdivide",)):
+                calculated_path = os.path.join(tmp, "calculated.csv")
+                mirrored_path = os.path.join(tmp, "mirrored.csv")
+                if run_calculator(grid, calculated_path, options + ("--no-symmetry",)) is None:
+                    return False
+                stderr = run_calculator(grid, mirrored_path, options)
+                if stderr is None or not same_files(calculated_path, mirrored_path):
+                    return False
+                mirrored = [line for line in stderr.splitlines()
+                            if line.startswith("Real-axis symmetry")]
+                if not mirrored:
+                    print(f"ERROR: No row of {grid[1]}..{grid[3]} was mirrored")
+                    return False
+                print(f"{' '.join((f'cb {grid[1]}..{grid[3]}',) + options)}: {mirrored[0]}")
+    print("✓ Test PASSED")
+    return True
+
+
+def test_resume():
+    """
+    Kill a streamed run right after a checkpoint, once after its second band
+    and once after the third checkpoint of a band in progress, resume it and
+    compare with a run that was not interrupted, in CSV and in the binary
+    format with a sidecar.
+    """
+    print("=" * 60)
+    print("Resume test")
+    print("=" * 60)
+    options = ("--stream", "--band-points", "200")
+    stops = (
+        # (checkpoint method, calls before the kill, checkpoint interval)
+        ("output_done", 2, "3600"),
+        ("save_band", 3, "0.000001"),
+    )
+    with tempfile.TemporaryDirectory() as tmp:
+        for output_options, extension in (((), ".csv"), (("--format", "grid", "--sidecar"), ".grid")):
+            whole_path = os.path.join(tmp, "whole" + extension)
+            if run_calculator(DECIDED_GRID, whole_path, options + output_options) is None:
+                return False
+            for method, calls, interval in stops:
+                path = os.path.join(tmp, "resumed" + extension)
+                run_options = options + output_options + ("--checkpoint-interval", interval)
+                patch = f"""
+import os
+original = box_calculator.CheckpointWriter.{method}
+calls = []
+def stop_after(self, *args):
+    original(self, *args)
+    calls.append(1)
+    if len(calls) == {calls}:
+        self.thread.join()
+        os._exit(3)
+box_calculator.CheckpointWriter.{method} = stop_after
+"""
+                killed = run_patched(patch, DECIDED_GRID, path, run_options)
+                if killed is None or killed.returncode != 3:
+                    print(f"ERROR: The run was not killed after {calls} calls of {method}")
+                    return False
+                stderr = run_calculator(DECIDED_GRID, path, run_options + ("--resume",))
+                if stderr is None or not same_files(whole_path, path):
+                    return False
+                if extension == ".grid" and not same_files(whole_path + ".z32", path + ".z32"):
+                    return False
+                if os.path.exists(path + ".ckpt"):
+                    print("ERROR: The checkpoint was not removed")
+                    return False
+                resumed = [line for line in stderr.splitlines() if line.startswith("Resuming")]
+                print(f"{extension[1:]}, killed after {method} #{calls}: {resumed[0]}")
+    print("✓ Test PASSED")
+    return True
+
+
+def test_deepen():
+    """
+    Deepening a shallow result gives the same output as a fresh run at the
+    deeper start_max_iterations, in CSV and in the binary format with a
+    sidecar.
+    """
+    print("=" * 60)
+    print("Deepen test")
+    print("=" * 60)
+    with tempfile.TemporaryDirectory() as tmp:
+        for grid, shallow, deep in DEEPEN_GRIDS:
+            for options, extension in (((), ".csv"), (("--format", "grid", "--sidecar"), ".grid")):
+                shallow_path = os.path.join(tmp, "shallow" + extension)
+                deepened_path = os.path.join(tmp, "deepened" + extension)
+                fresh_path = os.path.join(tmp, "fresh" + extension)
+                if (run_calculator(grid + [shallow, "2"], shallow_path, options) is None or
+                        run_calculator(grid + [deep, "2"], deepened_path,
+                                       options + ("--deepen", shallow_path)) is None or
+                        run_calculator(grid + [deep, "2"], fresh_path, options) is None):
+                    return False
+                if not same_files(fresh_path, deepened_path):
+                    return False
+                if extension == ".grid" and not same_files(fresh_path + ".z32",
+                                                           deepened_path + ".z32"):
+                    return False
+            print(f"Deepened from {shallow} to {deep} iterations as a fresh run "
+                  f"({len(grid[0])}-digit bounds)")
+    print("✓ Test PASSED")
+    return True
+
+
 if __name__ == '__main__':
-    success = run_test()
+    tests = [run_test, test_long_records, test_streaming, test_worker_failure, test_rounds,
+             test_subdivide, test_symmetry, test_resume, test_deepen]
+    # Run every test, even after a failure
+    success = all([test() for test in tests])
     sys.exit(0 if success else 1)
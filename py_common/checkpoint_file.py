@@ -0,0 +1,185 @@
+"""
+Checkpoint File of box_calculator.py
+
+Holds what a killed calculation needs to continue: how far the output file
+has been written, and the per-point state of the band being calculated.
+
+Layout (all integers and floats little-endian):
+
+    offset  size  field
+    0       8     magic b'MBCKPT1\\0'
+    8       4     key_size: length of the key text
+    12      4     rounds: number of adaptive rounds with counters
+    16      8     points_written: points 0 .. points_written - 1 are in the output
+    24      8     output_offset: byte size of the output that holds them (CSV only)
+    32      8     band_first: first point of the band in progress
+    40      8     band_count: points of that band, 0 if no band is in progress
+    48      8     judged: rounds of the band that passed the stopping rules
+    56      ...   key text (ASCII): the run parameters the checkpoint belongs to
+
+The key is followed by the round counters and the band columns:
+
+    returned    int64[rounds]      points that came back from each round
+    escaped     int64[rounds]      points that escaped in each round
+    escaped     uint8[band_count]  1 once the point escaped
+    round       uint8[band_count]  round the point has to run next
+    iterations  int64[band_count]  cumulative iterations
+    period      int64[band_count]  cycle length, 0 if none was found
+    smooth      float64[band_count]
+    z_size      uint64             length of the z text
+    z text      ASCII: the base-32 za of every point, then its zb, all
+                '\\n'-separated; the final z of decided points and the z
+                reached by undecided ones
+
+A checkpoint is written to a temporary file that is synced and renamed over
+the previous one, so a crash at any time leaves a complete checkpoint.
+"""
+
+import os
+import struct
+import sys
+from array import array
+from typing import List, Optional
+
+MAGIC = b'MBCKPT1\0'
+
+_HEADER = struct.Struct('<8sIIqqqqq')
+_SIZE = struct.Struct('<Q')
+
+
+def _little_endian(values: array) -> bytes:
+    if sys.byteorder != 'little':
+        values = array(values.typecode, values)
+        values.byteswap()
+    return values.tobytes()
+
+
+def _native(typecode: str, data: bytes) -> array:
+    values = array(typecode)
+    values.frombytes(data)
+    if sys.byteorder != 'little':
+        values.byteswap()
+    return values
+
+
+def checkpoint_path(path: str) -> str:
+    """Path of the checkpoint belonging to an output file."""
+    return path + '.ckpt'
+
+
+class Checkpoint:
+    """
+    Contents of a checkpoint file. The band columns are empty and band_count
+    is 0 between bands.
+
+    Attributes:
+        key: Run parameters, compared by the reader before resuming
+        points_written, output_offset: Progress of the output file
+        band_first, band_count, judged: The band in progress
+        returned, escaped_counts: Counters of every round (int64 arrays)
+        escaped, round: uint8 columns (bytes-like)
+        iterations, period: int64 columns; smooth: float64 column
+        final_za, final_zb: Base-32 z of every band point
+    """
+
+    def __init__(self, key: str, points_written: int, output_offset: int,
+                 band_first: int = 0, band_count: int = 0, judged: int = 0,
+                 returned: Optional[array] = None, escaped_counts: Optional[array] = None,
+                 escaped: bytes = b'', round: bytes = b'',
+                 iterations: Optional[array] = None, period: Optional[array] = None,
+                 smooth: Optional[array] = None,
+                 final_za: Optional[List[str]] = None, final_zb: Optional[List[str]] = None):
+        self.key = key
+        self.points_written = points_written
+        self.output_offset = output_offset
+        self.band_first = band_first
+        self.band_count = band_count
+        self.judged = judged
+        self.returned = returned if returned is not None else array('q')
+        self.escaped_counts = escaped_counts if escaped_counts is not None else array('q')
+        self.escaped = escaped
+        self.round = round
+        self.iterations = iterations if iterations is not None else array('q')
+        self.period = period if period is not None else array('q')
+        self.smooth = smooth if smooth is not None else array('d')
+        self.final_za = final_za if final_za is not None else []
+        self.final_zb = final_zb if final_zb is not None else []
+
+
+def write_checkpoint(path: str, checkpoint: Checkpoint):
+    """
+    Replace the checkpoint at path atomically: write a temporary file next to
+    it, sync it and rename it over the old one.
+    """
+    count = checkpoint.band_count
+    columns = [checkpoint.escaped, checkpoint.round, checkpoint.iterations,
+               checkpoint.period, checkpoint.smooth, checkpoint.final_za, checkpoint.final_zb]
+    if any(len(column) != count for column in columns):
+        raise ValueError(f"Band columns must hold {count} points")
+    if len(checkpoint.returned) != len(checkpoint.escaped_counts):
+        raise ValueError("Round counters differ in length")
+
+    key = checkpoint.key.encode('ascii')
+    z_text = '\n'.join(checkpoint.final_za + checkpoint.final_zb).encode('ascii')
+    tmp_path = f"{path}.{os.getpid()}.tmp"
+    try:
+        with open(tmp_path, 'wb') as f:
+            f.write(_HEADER.pack(MAGIC, len(key), len(checkpoint.returned),
+                                 checkpoint.points_written, checkpoint.output_offset,
+                                 checkpoint.band_first, count, checkpoint.judged))
+            f.write(key)
+            f.write(_little_endian(array('q', checkpoint.returned)))
+            f.write(_little_endian(array('q', checkpoint.escaped_counts)))
+            f.write(bytes(checkpoint.escaped))
+            f.write(bytes(checkpoint.round))
+            f.write(_little_endian(array('q', checkpoint.iterations)))
+            f.write(_little_endian(array('q', checkpoint.period)))
+            f.write(_little_endian(array('d', checkpoint.smooth)))
+            f.write(_SIZE.pack(len(z_text)))
+            f.write(z_text)
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(tmp_path, path)
+    except BaseException:
+        if os.path.exists(tmp_path):
+            os.unlink(tmp_path)
+        raise
+
+
+def read_checkpoint(path: str) -> Checkpoint:
+    """Read a checkpoint file; raises ValueError if it is not a complete one."""
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if len(data) < _HEADER.size:
+        raise ValueError(f"{path}: file too short for a checkpoint header")
+    (magic, key_size, rounds, points_written, output_offset,
+     band_first, count, judged) = _HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError(f"{path}: not a checkpoint file")
+
+    # Field sizes in file order, up to the z text
+    sizes = [key_size, 8 * rounds, 8 * rounds, count, count, 8 * count, 8 * count, 8 * count,
+             _SIZE.size]
+    if len(data) < _HEADER.size + sum(sizes):
+        raise ValueError(f"{path}: checkpoint is truncated")
+    fields = []
+    offset = _HEADER.size
+    for size in sizes:
+        fields.append(data[offset:offset + size])
+        offset += size
+    z_size, = _SIZE.unpack(fields[-1])
+    if len(data) != offset + z_size:
+        raise ValueError(f"{path}: checkpoint is truncated")
+
+    z_values = data[offset:].decode('ascii').split('\n') if count else []
+    if len(z_values) != 2 * count:
+        raise ValueError(f"{path}: checkpoint holds {len(z_values)} z values, "
+                         f"expected {2 * count}")
+
+    return Checkpoint(fields[0].decode('ascii'), points_written, output_offset,
+                      band_first, count, judged,
+                      _native('q', fields[1]), _native('q', fields[2]),
+                      bytearray(fields[3]), bytearray(fields[4]),
+                      _native('q', fields[5]), _native('q', fields[6]), _native('d', fields[7]),
+                      z_values[:count], z_values[count:])
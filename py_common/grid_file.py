@@ -0,0 +1,363 @@
+"""
+Binary Grid Result Format
+
+A compact alternative to the CSV written by box_calculator.py. The file holds a
+header and one fixed-width column per field, so readers can memory-map it into
+numpy arrays without copying or parsing anything per point.
+
+Layout (all integers and floats little-endian):
+
+    offset  size  field
+    0       8     magic b'MBGRID1\\0'
+    8       4     header_size: offset of the first column, a multiple of 64
+    12      4     flags: FLAG_FLOAT64 (final z stored as float64, else float32),
+                  FLAG_SMOOTH (a smooth iteration column is present)
+    16      8     resolution_ca
+    24      8     resolution_cb
+    32      8     precision of the calculation in bits
+    40      8     grid_precision: precision of the grid coordinates in bits
+    48      4     text_size: length of the text block
+    52      4     reserved (0)
+    56      ...   text block, '\\n'-separated ASCII: min_ca, min_cb, max_ca,
+                  max_cb, escape_radius, the resolution_ca column coordinates
+                  and the resolution_cb row coordinates (MPFR base-32)
+
+Columns follow the header in this order, each holding one value per point and
+starting at a multiple of 8 bytes:
+
+    escaped     uint8     1 if the point escaped, 0 otherwise
+    iterations  int64     total iterations performed
+    period      uint32    cycle length if one was detected, 0 otherwise
+    final_za    float32 or float64
+    final_zb    float32 or float64
+    smooth      float64   only with FLAG_SMOOTH
+
+Point (x, y) is stored at index x * resolution_cb + y, the order of the CSV
+rows, so every column reshapes to a (resolution_ca, resolution_cb) array.
+
+The final z values in the columns are rounded to floats. The exact base-32
+text can be kept in an optional sidecar file (sidecar_path()), laid out as:
+
+    0       8     magic b'MBGRIDZ\\0'
+    8       8     point count n
+    16      8*(2n+1)  offsets into the text, relative to its start
+    ...           text: final_za of point i is text[off[2i]:off[2i+1]] and
+                  final_zb is text[off[2i+1]:off[2i+2]]
+"""
+
+import mmap
+import os
+import struct
+import sys
+from array import array
+from typing import List, Optional, Sequence, Tuple
+
+MAGIC = b'MBGRID1\0'
+SIDECAR_MAGIC = b'MBGRIDZ\0'
+
+FLAG_FLOAT64 = 1
+FLAG_SMOOTH = 2
+
+_HEADER = struct.Struct('<8sIIQQQQII')
+_SIDECAR_HEADER = struct.Struct('<8sQ')
+_HEADER_ALIGN = 64
+_COLUMN_ALIGN = 8
+
+
+def _align(offset: int, alignment: int) -> int:
+    return (offset + alignment - 1) // alignment * alignment
+
+
+def _column_layout(flags: int) -> List[Tuple[str, str, int]]:
+    """Return (name, numpy dtype, item size) for every column present with flags."""
+    z_dtype, z_size = ('<f8', 8) if flags & FLAG_FLOAT64 else ('<f4', 4)
+    columns = [
+        ('escaped', 'u1', 1),
+        ('iterations', '<i8', 8),
+        ('period', '<u4', 4),
+        ('final_za', z_dtype, z_size),
+        ('final_zb', z_dtype, z_size),
+    ]
+    if flags & FLAG_SMOOTH:
+        columns.append(('smooth', '<f8', 8))
+    return columns
+
+
+def _little_endian(values: array) -> bytes:
+    if sys.byteorder != 'little':
+        values.byteswap()
+    return values.tobytes()
+
+
+def sidecar_path(path: str) -> str:
+    """Path of the full-precision sidecar belonging to a grid file."""
+    return path + '.z32'
+
+
+def is_grid_file(path: str) -> bool:
+    """Check whether path starts with the grid file magic (and is not a CSV)."""
+    with open(path, 'rb') as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+class GridFileWriter:
+    """
+    Write a grid file in pieces. The header is written and the file is sized
+    when the writer is created. write_points() then stores any run of
+    consecutive points into every column, so a grid can be written while it
+    is computed without holding more than one run in memory. With resume, an
+    existing file written with the same arguments is reopened instead, and
+    the points already in it are kept.
+
+    Args:
+        path: Output path
+        min_ca, min_cb, max_ca, max_cb, escape_radius: Bounds and escape radius
+            as given to the calculation (base-32)
+        precision: Precision of the calculation in bits
+        grid_precision: Precision of the grid coordinates in bits
+        ca_values, cb_values: Base-32 coordinate of every column and row
+        smooth: Whether the file has a smooth iteration column
+        float64: Store final z as float64 (True) or float32 (False)
+        resume: Reopen the existing file at path (ValueError if its header differs)
+    """
+
+    def __init__(self, path: str, min_ca: str, min_cb: str, max_ca: str, max_cb: str,
+                 escape_radius: str, precision: int, grid_precision: int,
+                 ca_values: Sequence[str], cb_values: Sequence[str],
+                 smooth: bool = False, float64: bool = True, resume: bool = False):
+        self.count = len(ca_values) * len(cb_values)
+        self.flags = (FLAG_FLOAT64 if float64 else 0) | (FLAG_SMOOTH if smooth else 0)
+        self._z_code = 'd' if float64 else 'f'
+
+        text = '\n'.join([min_ca, min_cb, max_ca, max_cb, escape_radius,
+                          *ca_values, *cb_values]).encode('ascii')
+        header_size = _align(_HEADER.size + len(text), _HEADER_ALIGN)
+
+        # Start offset and item size of every column
+        self._columns = {}
+        offset = header_size
+        for name, _, size in _column_layout(self.flags):
+            self._columns[name] = (offset, size)
+            offset += _align(self.count * size, _COLUMN_ALIGN)
+
+        header = _HEADER.pack(MAGIC, header_size, self.flags, len(ca_values),
+                              len(cb_values), precision, grid_precision, len(text), 0) + text
+        if resume:
+            self._file = open(path, 'r+b')
+            if (self._file.read(len(header)) != header or
+                    os.fstat(self._file.fileno()).st_size != offset):
+                self._file.close()
+                raise ValueError(f"{path}: grid file does not match the calculation")
+            return
+        self._file = open(path, 'wb')
+        self._file.write(header)
+        # Points not written yet (and the padding) read as zeros
+        self._file.truncate(offset)
+
+    def write_points(self, start: int, escaped: Sequence[bool], iterations: Sequence[int],
+                     period: Sequence[int], final_za: Sequence[float],
+                     final_zb: Sequence[float], smooth: Optional[Sequence[float]] = None):
+        """
+        Store points start, start + 1, ... (index order, x * resolution_cb + y).
+        smooth is required if and only if the writer was created with smooth=True.
+        """
+        data = {
+            'escaped': array('B', (1 if e else 0 for e in escaped)),
+            'iterations': array('q', iterations),
+            'period': array('I', period),
+            'final_za': array(self._z_code, final_za),
+            'final_zb': array(self._z_code, final_zb),
+        }
+        if smooth is not None:
+            data['smooth'] = array('d', smooth)
+        if set(data) != set(self._columns):
+            raise ValueError("smooth values must be given exactly when the file has them")
+
+        count = len(data['escaped'])
+        if start < 0 or start + count > self.count:
+            raise ValueError(f"Points {start}..{start + count - 1} outside the grid")
+        for name, values in data.items():
+            if len(values) != count:
+                raise ValueError(f"Column {name} has {len(values)} values, expected {count}")
+            offset, size = self._columns[name]
+            self._file.seek(offset + start * size)
+            self._file.write(_little_endian(values))
+
+    def flush(self):
+        """Hand the points written so far to the operating system."""
+        self._file.flush()
+
+    def close(self):
+        self._file.close()
+
+
+class SidecarWriter:
+    """
+    Write the full-precision sidecar of a grid file with count points in
+    pieces. Points must be written in index order. With start, the existing
+    sidecar is reopened and writing continues after its first start points;
+    anything written after them is discarded.
+    """
+
+    def __init__(self, path: str, count: int, start: int = 0):
+        self.count = count
+        self._next = start
+        self._text_start = _SIDECAR_HEADER.size + 8 * (2 * count + 1)
+        if start:
+            self._file = open(sidecar_path(path), 'r+b')
+            magic, stored_count = _SIDECAR_HEADER.unpack(self._file.read(_SIDECAR_HEADER.size))
+            if magic != SIDECAR_MAGIC or stored_count != count or start > count:
+                self._file.close()
+                raise ValueError(f"{sidecar_path(path)}: sidecar does not match the calculation")
+            # The text of the kept points ends where the offset of point start begins
+            self._file.seek(_SIDECAR_HEADER.size + 8 * 2 * start)
+            end, = struct.unpack('<Q', self._file.read(8))
+            self._text_end = self._text_start + end
+            self._file.truncate(self._text_end)
+            return
+        self._file = open(sidecar_path(path), 'wb')
+        self._file.write(_SIDECAR_HEADER.pack(SIDECAR_MAGIC, count))
+        self._file.write(_little_endian(array('Q', [0])))
+        self._text_end = self._text_start
+        self._file.truncate(self._text_start)
+
+    def write_points(self, final_za: Sequence[str], final_zb: Sequence[str]):
+        """Store the base-32 final z of the next points."""
+        if self._next + len(final_za) > self.count:
+            raise ValueError("More points than the sidecar was created for")
+        offsets = array('Q')
+        chunks = []
+        position = self._text_end - self._text_start
+        for za, zb in zip(final_za, final_zb):
+            for value in (za, zb):
+                encoded = value.encode('ascii')
+                chunks.append(encoded)
+                position += len(encoded)
+                offsets.append(position)
+
+        # Offsets 2 * next + 1 ... of the table, then the text at the end
+        self._file.seek(_SIDECAR_HEADER.size + 8 * (2 * self._next + 1))
+        self._file.write(_little_endian(offsets))
+        self._file.seek(self._text_end)
+        self._file.write(b''.join(chunks))
+        self._text_end = self._text_start + position
+        self._next += len(final_za)
+
+    def flush(self):
+        """Hand the points written so far to the operating system."""
+        self._file.flush()
+
+    def close(self):
+        self._file.close()
+
+
+def write_grid_file(path: str, min_ca: str, min_cb: str, max_ca: str, max_cb: str,
+                    escape_radius: str, precision: int, grid_precision: int,
+                    ca_values: Sequence[str], cb_values: Sequence[str],
+                    escaped: Sequence[bool], iterations: Sequence[int],
+                    period: Sequence[int], final_za: Sequence[float],
+                    final_zb: Sequence[float], smooth: Optional[Sequence[float]] = None,
+                    float64: bool = True):
+    """
+    Write a whole grid file at once. All per-point sequences are in index order
+    (x * len(cb_values) + y); the other arguments are those of GridFileWriter.
+    """
+    writer = GridFileWriter(path, min_ca, min_cb, max_ca, max_cb, escape_radius,
+                            precision, grid_precision, ca_values, cb_values,
+                            smooth=smooth is not None, float64=float64)
+    try:
+        if len(escaped) != writer.count:
+            raise ValueError(f"Got {len(escaped)} points, expected {writer.count}")
+        writer.write_points(0, escaped, iterations, period, final_za, final_zb, smooth)
+    finally:
+        writer.close()
+
+
+def write_sidecar(path: str, final_za: Sequence[str], final_zb: Sequence[str]):
+    """
+    Write the full-precision final z of every point (base-32 text, index order)
+    to the sidecar of the grid file at path.
+    """
+    writer = SidecarWriter(path, len(final_za))
+    try:
+        writer.write_points(final_za, final_zb)
+    finally:
+        writer.close()
+
+
+class GridFile:
+    """
+    Read-only view of a grid file. The file is memory-mapped once and every
+    column is a numpy array of shape (resolution_ca, resolution_cb) backed by
+    the mapping, so nothing is copied or parsed per point until it is used.
+    The mapping stays open as long as any of the arrays is referenced.
+
+    Attributes:
+        resolution_ca, resolution_cb, precision, grid_precision: From the header
+        min_ca, min_cb, max_ca, max_cb, escape_radius: Base-32 strings
+        ca_values, cb_values: Base-32 coordinate of every column and row
+        escaped, iterations, period, final_za, final_zb: Column arrays
+        smooth: Column array, or None if the file has no smooth values
+    """
+
+    def __init__(self, path: str):
+        # numpy is only needed for reading
+        import numpy as np
+
+        self.path = path
+        with open(path, 'rb') as f:
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(self._map) < _HEADER.size:
+            raise ValueError(f"{path}: file too short for a grid header")
+        (magic, header_size, flags, self.resolution_ca, self.resolution_cb,
+         self.precision, self.grid_precision, text_size, _) = _HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC:
+            raise ValueError(f"{path}: not a grid file")
+
+        text = self._map[_HEADER.size:_HEADER.size + text_size].decode('ascii').split('\n')
+        (self.min_ca, self.min_cb, self.max_ca, self.max_cb, self.escape_radius) = text[:5]
+        self.ca_values = text[5:5 + self.resolution_ca]
+        self.cb_values = text[5 + self.resolution_ca:]
+
+        count = self.resolution_ca * self.resolution_cb
+        shape = (self.resolution_ca, self.resolution_cb)
+        offset = header_size
+        self.smooth = None
+        for name, dtype, size in _column_layout(flags):
+            column = np.frombuffer(self._map, dtype=dtype, count=count, offset=offset)
+            setattr(self, name, column.reshape(shape))
+            offset += _align(count * size, _COLUMN_ALIGN)
+
+        self._sidecar = None
+        self._sidecar_offsets = None
+
+    def _open_sidecar(self):
+        import numpy as np
+
+        with open(sidecar_path(self.path), 'rb') as f:
+            self._sidecar = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, count = _SIDECAR_HEADER.unpack_from(self._sidecar, 0)
+        if magic != SIDECAR_MAGIC or count != self.resolution_ca * self.resolution_cb:
+            raise ValueError(f"{sidecar_path(self.path)}: sidecar does not match {self.path}")
+        self._sidecar_offsets = np.frombuffer(self._sidecar, dtype='<u8',
+                                              count=2 * count + 1,
+                                              offset=_SIDECAR_HEADER.size)
+        self._sidecar_text = _SIDECAR_HEADER.size + 8 * (2 * count + 1)
+
+    def has_sidecar(self) -> bool:
+        """Check whether the full-precision sidecar exists."""
+        return self._sidecar is not None or os.path.exists(sidecar_path(self.path))
+
+    def final_z_text(self, x: int, y: int) -> Tuple[str, str]:
+        """
+        Return the full-precision final z of point (x, y) as base-32 strings.
+        Raises FileNotFoundError if the file was written without a sidecar.
+        """
+        if self._sidecar is None:
+            self._open_sidecar()
+        i = 2 * (x * self.resolution_cb + y)
+        start = self._sidecar_text
+        za_start, zb_start, zb_end = (int(o) for o in self._sidecar_offsets[i:i + 3])
+        return (self._sidecar[start + za_start:start + zb_start].decode('ascii'),
+                self._sidecar[start + zb_start:start + zb_end].decode('ascii'))
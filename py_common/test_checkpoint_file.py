@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Test script for checkpoint_file.py (checkpoints of box_calculator.py)
+"""
+
+import os
+import sys
+import tempfile
+from array import array
+
+from checkpoint_file import Checkpoint, checkpoint_path, read_checkpoint, write_checkpoint
+
+# Colors for output
+GREEN = '\033[0;32m'
+RED = '\033[0;31m'
+NC = '\033[0m'  # No Color
+
+PASSED = 0
+FAILED = 0
+
+
+def check(test_name, expected, got):
+    """Compare one value read back with the value written."""
+    global PASSED, FAILED
+
+    if got == expected:
+        print(f"{GREEN}✓{NC} {test_name}")
+        PASSED += 1
+    else:
+        print(f"{RED}✗{NC} {test_name}")
+        print(f"  Expected: {expected}")
+        print(f"  Got:      {got}")
+        FAILED += 1
+
+
+def expect_error(test_name, path):
+    """Check that reading path fails with ValueError."""
+    try:
+        read_checkpoint(path)
+        check(test_name, 'ValueError', 'no error')
+    except ValueError:
+        check(test_name, 'ValueError', 'ValueError')
+
+
+# A band of 4 points in round 2: two escaped, one periodic, one undecided
+KEY = 'box_calculator -2 -1 1 1 4 100 2 csv'
+EXAMPLE = Checkpoint(KEY, 8, 1234, band_first=8, band_count=4, judged=1,
+                     returned=array('q', [4, 2, 1]), escaped_counts=array('q', [2, 1, 0]),
+                     escaped=bytearray([1, 0, 1, 0]), round=bytearray([0, 0, 1, 2]),
+                     iterations=array('q', [3, 100, 150, 5000000000]),
+                     period=array('q', [0, 2, 0, 0]),
+                     smooth=array('d', [2.5, 0.0, 149.25, 0.0]),
+                     final_za=['2.8', '-1', '-3.g', '0.lalalalalalalalalalalalalc'],
+                     final_zb=['0', '0', '1@-ff', '-0.6ak'])
+
+
+print("Testing checkpoint_file.py...")
+print()
+
+with tempfile.TemporaryDirectory() as directory:
+    path = checkpoint_path(os.path.join(directory, 'out.csv'))
+    check("Checkpoint path", os.path.join(directory, 'out.csv.ckpt'), path)
+
+    # Test 2-6: A band in progress reads back unchanged
+    write_checkpoint(path, EXAMPLE)
+    got = read_checkpoint(path)
+    check("Band: key and output progress", (KEY, 8, 1234),
+          (got.key, got.points_written, got.output_offset))
+    check("Band: position and judged rounds", (8, 4, 1), (got.band_first, got.band_count, got.judged))
+    check("Band: round counters", ([4, 2, 1], [2, 1, 0]),
+          (got.returned.tolist(), got.escaped_counts.tolist()))
+    check("Band: point columns",
+          ([1, 0, 1, 0], [0, 0, 1, 2], EXAMPLE.iterations.tolist(), [0, 2, 0, 0],
+           EXAMPLE.smooth.tolist()),
+          (list(got.escaped), list(got.round), got.iterations.tolist(), got.period.tolist(),
+           got.smooth.tolist()))
+    check("Band: z text", (EXAMPLE.final_za, EXAMPLE.final_zb), (got.final_za, got.final_zb))
+
+    # Test 7: Between bands only the output progress is stored
+    write_checkpoint(path, Checkpoint(KEY, 12, 0))
+    got = read_checkpoint(path)
+    check("Between bands", (12, 0, 0, [], [], []),
+          (got.points_written, got.band_count, len(got.returned), list(got.escaped),
+           got.final_za, got.final_zb))
+
+    # Test 8: Replacing leaves no temporary file behind
+    check("No temporary files", ['out.csv.ckpt'], sorted(os.listdir(directory)))
+
+    # Test 9-10: Truncated and foreign files are rejected
+    write_checkpoint(path, EXAMPLE)
+    with open(path, 'rb') as f:
+        data = f.read()
+    with open(path, 'wb') as f:
+        f.write(data[:-3])
+    expect_error("Reject truncated checkpoint", path)
+    with open(path, 'wb') as f:
+        f.write(b'X,Y,CA,CB\n' + data[10:])
+    expect_error("Reject foreign file", path)
+
+    # Test 11: Columns of the wrong length are not written
+    try:
+        write_checkpoint(path, Checkpoint(KEY, 0, 0, band_count=2, escaped=bytearray(1)))
+        check("Reject inconsistent band", 'ValueError', 'no error')
+    except ValueError:
+        check("Reject inconsistent band", 'ValueError', 'ValueError')
+
+# Summary
+print()
+print("=" * 60)
+print(f"Total tests: {PASSED + FAILED}")
+print(f"Passed: {PASSED}")
+print(f"Failed: {FAILED}")
+print("=" * 60)
+
+if FAILED == 0:
+    print(f"{GREEN}All tests passed! ✓{NC}")
+    sys.exit(0)
+else:
+    print(f"{RED}Some tests failed!{NC}")
+    sys.exit(1)
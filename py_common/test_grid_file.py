@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Test script for grid_file.py (binary grid result format)
+"""
+
+import os
+import sys
+import tempfile
+
+from grid_file import (GridFile, GridFileWriter, SidecarWriter, is_grid_file, sidecar_path,
+                       write_grid_file, write_sidecar)
+
+# Colors for output
+GREEN = '\033[0;32m'
+RED = '\033[0;31m'
+NC = '\033[0m'  # No Color
+
+PASSED = 0
+FAILED = 0
+
+
+def check(test_name, expected, got):
+    """Compare one value read back with the value written."""
+    global PASSED, FAILED
+
+    if got == expected:
+        print(f"{GREEN}✓{NC} {test_name}")
+        PASSED += 1
+    else:
+        print(f"{RED}✗{NC} {test_name}")
+        print(f"  Expected: {expected}")
+        print(f"  Got:      {got}")
+        FAILED += 1
+
+
+# A 3x2 grid; point (x, y) is at index x * 2 + y
+CA_VALUES = ['-2', '-0.lalalalalalalalalalalalalc', '0.lalalalalalalalalalalalalc']
+CB_VALUES = ['-1', '0']
+ESCAPED = [True, True, False, True, False, False]
+ITERATIONS = [1, 3, 100, 5000000000, 12, 0]
+PERIOD = [0, 0, 0, 0, 3, 1]
+FINAL_ZA = [-3.5, 2.25, 0.1, -1e300, 0.0, 0.0]
+FINAL_ZB = [0.5, -7.0, 0.2, 1e-300, 0.5, 0.0]
+FINAL_ZA_TEXT = ['-3.g', '2.8', '0.35c', '-1@ff', '0', '0']
+FINAL_ZB_TEXT = ['0.g', '-7', '0.6ak', '1@-ff', '0.g', '0']
+
+
+def write_example(path, smooth=None, float64=True):
+    write_grid_file(path, '-2', '-1', '1', '1', '2', 128, 192, CA_VALUES, CB_VALUES,
+                    ESCAPED, ITERATIONS, PERIOD, FINAL_ZA, FINAL_ZB,
+                    smooth=smooth, float64=float64)
+
+
+def flat(array):
+    return [value for row in array.tolist() for value in row]
+
+
+print("Testing grid_file.py...")
+print()
+
+with tempfile.TemporaryDirectory() as directory:
+    # Test 1-10: Header and columns
+    path = os.path.join(directory, 'grid.mbg')
+    write_example(path)
+    grid = GridFile(path)
+
+    check("Header: resolutions", (3, 2), (grid.resolution_ca, grid.resolution_cb))
+    check("Header: precisions", (128, 192), (grid.precision, grid.grid_precision))
+    check("Header: bounds and escape radius", ('-2', '-1', '1', '1', '2'),
+          (grid.min_ca, grid.min_cb, grid.max_ca, grid.max_cb, grid.escape_radius))
+    check("Header: axis coordinates", (CA_VALUES, CB_VALUES),
+          (list(grid.ca_values), list(grid.cb_values)))
+    check("Column: escaped", [1 if e else 0 for e in ESCAPED], flat(grid.escaped))
+    check("Column: iterations beyond 32 bits", ITERATIONS, flat(grid.iterations))
+    check("Column: period", PERIOD, flat(grid.period))
+    check("Column: float64 final z", (FINAL_ZA, FINAL_ZB),
+          (flat(grid.final_za), flat(grid.final_zb)))
+    check("Column: indexed as [x][y]", 5000000000, grid.iterations.tolist()[1][1])
+    check("No smooth column", None, grid.smooth)
+
+    # Test 11-13: Optional columns and float32
+    smooth_path = os.path.join(directory, 'smooth.mbg')
+    write_example(smooth_path, smooth=[0.5, 1.5, 2.5, 3.5, 4.5, 5.5], float64=False)
+    grid = GridFile(smooth_path)
+    check("Smooth column", [0.5, 1.5, 2.5, 3.5, 4.5, 5.5], flat(grid.smooth))
+    check("Float32 final z", [-3.5, 2.25, 0.5, -7.0], flat(grid.final_za)[:2] + flat(grid.final_zb)[:2])
+    check("Columns after float32 z stay in place", ITERATIONS, flat(grid.iterations))
+
+    # Test 14-16: Sidecar
+    check("No sidecar written", False, GridFile(path).has_sidecar())
+    write_sidecar(path, FINAL_ZA_TEXT, FINAL_ZB_TEXT)
+    grid = GridFile(path)
+    check("Sidecar found", True, grid.has_sidecar())
+    check("Sidecar: full-precision final z",
+          list(zip(FINAL_ZA_TEXT, FINAL_ZB_TEXT)),
+          [grid.final_z_text(x, y) for x in range(3) for y in range(2)])
+
+    # Test 17-18: Format detection
+    csv_path = os.path.join(directory, 'grid.csv')
+    with open(csv_path, 'w') as f:
+        f.write('X,Y,CA,CB,ESCAPED,ITERATIONS,FINAL_ZA,FINAL_ZB,PERIOD\n')
+    check("Detect grid file", True, is_grid_file(path))
+    check("Detect CSV file", False, is_grid_file(csv_path))
+
+    # Test 19: Reading a CSV as a grid file fails cleanly
+    try:
+        GridFile(csv_path)
+        check("Reject CSV file", 'ValueError', 'no error')
+    except ValueError:
+        check("Reject CSV file", 'ValueError', 'ValueError')
+
+    check("Sidecar path", path + '.z32', sidecar_path(path))
+
+    # Test 21-23: Writing in pieces gives the same file
+    pieces_path = os.path.join(directory, 'pieces.mbg')
+    writer = GridFileWriter(pieces_path, '-2', '-1', '1', '1', '2', 128, 192, CA_VALUES, CB_VALUES)
+    sidecar = SidecarWriter(pieces_path, 6)
+    for start, end in ((4, 6), (0, 1), (1, 4)):
+        writer.write_points(start, ESCAPED[start:end], ITERATIONS[start:end], PERIOD[start:end],
+                            FINAL_ZA[start:end], FINAL_ZB[start:end])
+    for start, end in ((0, 1), (1, 4), (4, 6)):
+        sidecar.write_points(FINAL_ZA_TEXT[start:end], FINAL_ZB_TEXT[start:end])
+    writer.close()
+    sidecar.close()
+    with open(path, 'rb') as f, open(pieces_path, 'rb') as g:
+        check("Pieces: same grid file", f.read(), g.read())
+    with open(sidecar_path(path), 'rb') as f, open(sidecar_path(pieces_path), 'rb') as g:
+        check("Pieces: same sidecar", f.read(), g.read())
+
+    writer = GridFileWriter(pieces_path, '-2', '-1', '1', '1', '2', 128, 192, CA_VALUES, CB_VALUES)
+    try:
+        writer.write_points(5, [True, True], [1, 2], [0, 0], [0.0, 0.0], [0.0, 0.0])
+        check("Pieces: reject points outside the grid", 'ValueError', 'no error')
+    except ValueError:
+        check("Pieces: reject points outside the grid", 'ValueError', 'ValueError')
+    writer.close()
+
+    # Test 25-27: Resuming keeps the points written before and drops the rest
+    resumed_path = os.path.join(directory, 'resumed.mbg')
+    writer = GridFileWriter(resumed_path, '-2', '-1', '1', '1', '2', 128, 192, CA_VALUES, CB_VALUES)
+    sidecar = SidecarWriter(resumed_path, 6)
+    writer.write_points(0, ESCAPED[:4], ITERATIONS[:4], PERIOD[:4], FINAL_ZA[:4], FINAL_ZB[:4])
+    sidecar.write_points(FINAL_ZA_TEXT[:4], FINAL_ZB_TEXT[:4])
+    sidecar.write_points(['lost'], ['lost'])
+    writer.close()
+    sidecar.close()
+    writer = GridFileWriter(resumed_path, '-2', '-1', '1', '1', '2', 128, 192, CA_VALUES, CB_VALUES,
+                            resume=True)
+    sidecar = SidecarWriter(resumed_path, 6, start=4)
+    writer.write_points(4, ESCAPED[4:], ITERATIONS[4:], PERIOD[4:], FINAL_ZA[4:], FINAL_ZB[4:])
+    sidecar.write_points(FINAL_ZA_TEXT[4:], FINAL_ZB_TEXT[4:])
+    writer.close()
+    sidecar.close()
+    with open(path, 'rb') as f, open(resumed_path, 'rb') as g:
+        check("Resume: same grid file", f.read(), g.read())
+    with open(sidecar_path(path), 'rb') as f, open(sidecar_path(resumed_path), 'rb') as g:
+        check("Resume: same sidecar", f.read(), g.read())
+
+    try:
+        GridFileWriter(resumed_path, '-2', '-1', '1', '1', '2', 128, 192, CA_VALUES, CB_VALUES,
+                       smooth=True, resume=True)
+        check("Resume: reject a different grid file", 'ValueError', 'no error')
+    except ValueError:
+        check("Resume: reject a different grid file", 'ValueError', 'ValueError')
+
+# Summary
+print()
+print("=" * 60)
+print(f"Total tests: {PASSED + FAILED}")
+print(f"Passed: {PASSED}")
+print(f"Failed: {FAILED}")
+print("=" * 60)
+
+if FAILED == 0:
+    print(f"{GREEN}All tests passed! ✓{NC}")
+    sys.exit(0)
+else:
+    print(f"{RED}Some tests failed!{NC}")
+    sys.exit(1)
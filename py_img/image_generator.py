@@ -2,8 +2,10 @@
 """
 Mandelbrot Set Image Generator
 
-Reads CSV output from box_calculator.py and generates a smooth-colored PNG image.
-Uses continuous coloring based on escape iterations and final z-value magnitude.
+Reads CSV or binary grid output from box_calculator.py and generates a
+smooth-colored PNG image.
+Uses continuous coloring based on escape iterations and final z-value magnitude,
+or on the smooth iteration count stored by box_calculator.py --smooth.
 """
 
 import sys
@@ -11,6 +13,13 @@ import csv
 import math
 from PIL import Image
 import colorsys
+from pathlib import Path
+from typing import Optional
+
+# Add py_common to path for imports
+sys.path.insert(0, str(Path(__file__).parent.parent / 'py_common'))
+
+from grid_file import GridFile, is_grid_file  # type: ignore
 
 
 def parse_base32_float(s: str) -> float:
@@ -70,7 +79,8 @@ def parse_base32_float(s: str) -> float:
     return sign * value
 
 
-def calculate_smooth_color(iterations: int, max_iterations: int, final_za: float, final_zb: float, escape_radius: float = 2.0) -> tuple:
+def calculate_smooth_color(iterations: int, max_iterations: int, final_za: float, final_zb: float,
+                           escape_radius: float = 2.0, smooth: Optional[float] = None) -> tuple:
     """
     Calculate smooth RGB color for a point.
     
@@ -80,6 +90,8 @@ def calculate_smooth_color(iterations: int, max_iterations: int, final_za: float
         final_za: Real part of final z value
         final_zb: Imaginary part of final z value
         escape_radius: Escape radius used in calculation
+        smooth: Normalized iteration count computed by the mandelbrot process;
+                if given, final z is not used
     
     Returns:
         (R, G, B) tuple with values 0-255
@@ -88,16 +100,19 @@ def calculate_smooth_color(iterations: int, max_iterations: int, final_za: float
     if iterations >= max_iterations:
         return (0, 0, 0)
     
-    # Calculate magnitude of final z
-    z_mag = math.sqrt(final_za * final_za + final_zb * final_zb)
-    
-    # Smooth continuous coloring using normalized iteration count
-    # Formula: nu = n + 1 - log(log|z|) / log(2)
-    # This creates smooth color transitions
-    if z_mag > 0:
-        smooth_iter = iterations + 1 - math.log(math.log(z_mag)) / math.log(2.0)
+    if smooth is not None:
+        smooth_iter = smooth
     else:
-        smooth_iter = float(iterations)
+        # Calculate magnitude of final z
+        z_mag = math.sqrt(final_za * final_za + final_zb * final_zb)
+        
+        # Smooth continuous coloring using normalized iteration count
+        # Formula: nu = n + 1 - log(log|z|) / log(2)
+        # This creates smooth color transitions
+        if z_mag > 0:
+            smooth_iter = iterations + 1 - math.log(math.log(z_mag)) / math.log(2.0)
+        else:
+            smooth_iter = float(iterations)
     
     # Normalize to 0-1 range
     # Use logarithmic scaling for better color distribution
@@ -117,44 +132,91 @@ def calculate_smooth_color(iterations: int, max_iterations: int, final_za: float
     return (int(r * 255), int(g * 255), int(b * 255))
 
 
-def generate_image(csv_path: str, output_path: str):
+def load_csv_points(csv_path: str) -> list:
     """
-    Generate Mandelbrot set image from CSV data.
-    
-    Args:
-        csv_path: Path to input CSV file
-        output_path: Path to output PNG image
+    Read the points of a CSV file. With a SMOOTH column its values are used
+    and final z is not parsed; otherwise final z is parsed from base-32.
     """
-    print(f"Reading CSV from: {csv_path}")
-    
-    # Read CSV data
     data_points = []
-    max_x = 0
-    max_y = 0
-    max_iterations = 0
-    
     with open(csv_path, 'r') as f:
         reader = csv.DictReader(f)
+        has_smooth = 'SMOOTH' in (reader.fieldnames or [])
         for row in reader:
-            x = int(row['X'])
-            y = int(row['Y'])
-            iterations = int(row['ITERATIONS'])
+            # Points with a detected cycle stopped early but are in the set
+            periodic = int(row.get('PERIOD') or 0) > 0
             
-            # Parse base-32 float values
-            final_za = parse_base32_float(row['FINAL_ZA'])
-            final_zb = parse_base32_float(row['FINAL_ZB'])
+            if has_smooth:
+                final_za = final_zb = 0.0
+                smooth = float(row['SMOOTH']) if row['SMOOTH'] else None
+            else:
+                final_za = parse_base32_float(row['FINAL_ZA'])
+                final_zb = parse_base32_float(row['FINAL_ZB'])
+                smooth = None
             
+            data_points.append({
+                'x': int(row['X']),
+                'y': int(row['Y']),
+                'iterations': int(row['ITERATIONS']),
+                'periodic': periodic,
+                'final_za': final_za,
+                'final_zb': final_zb,
+                'smooth': smooth
+            })
+    return data_points
+
+
+def load_grid_points(path: str) -> list:
+    """
+    Read the points of a binary grid file; final z is already stored as
+    floats, and the smooth column is used if the file has one.
+    """
+    grid = GridFile(path)
+    escaped = grid.escaped.tolist()
+    iterations = grid.iterations.tolist()
+    period = grid.period.tolist()
+    final_za = grid.final_za.tolist()
+    final_zb = grid.final_zb.tolist()
+    smooth = grid.smooth.tolist() if grid.smooth is not None else None
+    
+    data_points = []
+    for x in range(grid.resolution_ca):
+        for y in range(grid.resolution_cb):
             data_points.append({
                 'x': x,
                 'y': y,
-                'iterations': iterations,
-                'final_za': final_za,
-                'final_zb': final_zb
+                'iterations': iterations[x][y],
+                'periodic': period[x][y] > 0,
+                'final_za': final_za[x][y],
+                'final_zb': final_zb[x][y],
+                'smooth': smooth[x][y] if smooth is not None and escaped[x][y] else None
             })
-            
-            max_x = max(max_x, x)
-            max_y = max(max_y, y)
-            max_iterations = max(max_iterations, iterations)
+    return data_points
+
+
+def generate_image(csv_path: str, output_path: str):
+    """
+    Generate Mandelbrot set image from CSV or binary grid data.
+    
+    Args:
+        csv_path: Path to input CSV or binary grid file
+        output_path: Path to output PNG image
+    """
+    print(f"Reading data from: {csv_path}")
+    
+    # Read data
+    max_x = 0
+    max_y = 0
+    max_iterations = 0
+    
+    if is_grid_file(csv_path):
+        data_points = load_grid_points(csv_path)
+    else:
+        data_points = load_csv_points(csv_path)
+    
+    for point in data_points:
+        max_x = max(max_x, point['x'])
+        max_y = max(max_y, point['y'])
+        max_iterations = max(max_iterations, point['iterations'])
     
     # Calculate image dimensions
     width = max_x + 1
@@ -177,7 +239,11 @@ def generate_image(csv_path: str, output_path: str):
         final_za = point['final_za']
         final_zb = point['final_zb']
         
-        color = calculate_smooth_color(iterations, max_iterations, final_za, final_zb)
+        if point['periodic']:
+            color = (0, 0, 0)
+        else:
+            color = calculate_smooth_color(iterations, max_iterations, final_za, final_zb,
+                                           smooth=point['smooth'])
         pixels[x, y] = color
     
     # Save image
@@ -187,7 +253,7 @@ def generate_image(csv_path: str, output_path: str):
 
 def main():
     if len(sys.argv) != 3:
-        print("Usage: python3 image_generator.py <input_csv_path> <output_image_path>")
+        print("Usage: python3 image_generator.py <input_csv_or_grid_path> <output_image_path>")
         print("\nExample:")
         print("  python3 image_generator.py ../tmp/full.csv output.png")
         sys.exit(1)
@@ -22,10 +22,36 @@ sys.path.insert(0, str(Path(__file__).parent.parent / 'py_common'))
 
 import gmpy2
 from mpfr_base32 import parse_mpfr_base32, decimal_to_mpfr_base32
+from grid_file import GridFile, is_grid_file
+
+
+def load_grid_data(path: str) -> List[Dict]:
+    """
+    Load calculation results from a binary grid file. CA and CB come from the
+    stored axis coordinates; FINAL_ZA and FINAL_ZB are not needed here and are
+    left out, so the full-precision sidecar is never read.
+    """
+    grid = GridFile(path)
+    escaped = grid.escaped.tolist()
+    iterations = grid.iterations.tolist()
+    data = []
+    for x in range(grid.resolution_ca):
+        for y in range(grid.resolution_cb):
+            data.append({
+                'X': x,
+                'Y': y,
+                'CA': grid.ca_values[x],
+                'CB': grid.cb_values[y],
+                'ESCAPED': 'Y' if escaped[x][y] else 'N',
+                'ITERATIONS': iterations[x][y]
+            })
+    return data
 
 
 def load_csv_data(csv_path: str) -> List[Dict]:
-    """Load calculation results from CSV file."""
+    """Load calculation results from CSV file (or a binary grid file)."""
+    if is_grid_file(csv_path):
+        return load_grid_data(csv_path)
     data = []
     with open(csv_path, 'r') as f:
         reader = csv.DictReader(f)
@@ -258,7 +284,7 @@ with 3× magnification centered on a high-complexity boundary point.
     parser.add_argument('max_cb', type=str,
                        help='Maximum imaginary part of c from previous calculation (base-32)')
     parser.add_argument('input_csv_path', type=str,
-                       help='Path to CSV output from box_calculator.py')
+                       help='Path to CSV or binary grid output from box_calculator.py')
     parser.add_argument('magnification_ratio', type=float,
                        help='Zoom magnification factor (e.g., 2.0 = 2× zoom, must be > 1.0)')
     parser.add_argument('--seed', type=int, default=None,